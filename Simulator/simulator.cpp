@@ -0,0 +1,88 @@
+#include "../frametransport.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <unistd.h>
+
+// Receiving side of the hardware link, running as a local process instead of the display.
+// Reads packets from stdin, answers with acknowledges on stdout (unless --no-acknowledge is given)
+// and prints some statistics on stderr.
+//
+// usage: Simulator [--no-acknowledge] [numberOfLedsX numberOfLedsY]
+//
+// Connected via socketpair() to SetHardwareLink(fd, true), or via a pipe to SetHardwareLink(fd, false).
+
+constexpr int c_DefaultNumberOfLedsX = 64;
+constexpr int c_DefaultNumberOfLedsY = 32;
+constexpr long c_StatisticsIntervalInFrames = 100;
+
+static bool WriteAll(int fileDescriptor_p, const PacketBuffer& data_p) {
+    std::size_t bytesWritten{0};
+    while (bytesWritten < data_p.size()) {
+        const ssize_t result{write(fileDescriptor_p, data_p.data() + bytesWritten, data_p.size() - bytesWritten)};
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        bytesWritten += static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    bool sendAcknowledges{true};
+    int numberOfLedsX{c_DefaultNumberOfLedsX};
+    int numberOfLedsY{c_DefaultNumberOfLedsY};
+
+    int argument{1};
+    if (argument < argc && std::strcmp(argv[argument], "--no-acknowledge") == 0) {
+        sendAcknowledges = false;
+        argument++;
+    }
+    if (argument + 1 < argc) {
+        numberOfLedsX = std::atoi(argv[argument]);
+        numberOfLedsY = std::atoi(argv[argument + 1]);
+    }
+
+    FrameDecoder decoder(numberOfLedsX * numberOfLedsY);
+    std::uint8_t receiveBuffer[4096];
+    long bytesReceived{0};
+
+    while (true) {
+        const ssize_t bytesRead{read(STDIN_FILENO, receiveBuffer, sizeof(receiveBuffer))};
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead <= 0) {
+            break;
+        }
+        bytesReceived += bytesRead;
+
+        const long decodedFramesBefore{decoder.GetNumberOfDecodedFrames()};
+        decoder.ProcessIncoming(receiveBuffer, static_cast<std::size_t>(bytesRead));
+
+        const PacketBuffer outgoing{decoder.TakeOutgoing()};
+        if (sendAcknowledges && !WriteAll(STDOUT_FILENO, outgoing)) {
+            std::cerr << "SIMULATOR: writing acknowledges failed - continuing without." << std::endl;
+            sendAcknowledges = false;
+        }
+
+        const long decodedFrames{decoder.GetNumberOfDecodedFrames()};
+        if (decodedFrames / c_StatisticsIntervalInFrames != decodedFramesBefore / c_StatisticsIntervalInFrames) {
+            std::cerr << "SIMULATOR: frames: " << decodedFrames
+                      << ", bytes per frame: " << bytesReceived / decodedFrames
+                      << ", dropped packets: " << decoder.GetNumberOfDroppedPackets()
+                      << ", dropped bytes: " << decoder.GetNumberOfDroppedBytes() << std::endl;
+        }
+    }
+
+    std::cerr << "SIMULATOR: link closed after " << decoder.GetNumberOfDecodedFrames() << " frames and "
+              << bytesReceived << " bytes." << std::endl;
+    return 0;
+}
@@ -1,9 +1,40 @@
 #include "../library.h"
+#include "../frametransport.h"
+#include "../internal.h"
+#include "../videosource.h"
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
 
 #include <gtest/gtest.h>
 
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 constexpr int c_SleepTimeAfterLedTestInSeconds = 5;
 
+// writes a y4m file with frames of one color each (y, u, v)
+static std::string WriteTestY4m(const std::string& fileName_p, int width_p, int height_p,
+                                const std::vector<std::vector<int>>& framesYuv_p, const std::string& frameRate_p = "F25:1") {
+    const std::string path{testing::TempDir() + fileName_p};
+    std::ofstream file(path, std::ios::binary);
+    file << "YUV4MPEG2 W" << width_p << " H" << height_p << " " << frameRate_p << " Ip A1:1 C420jpeg\n";
+    const int chromaSize{((width_p + 1) / 2) * ((height_p + 1) / 2)};
+    for (const auto& yuv : framesYuv_p) {
+        file << "FRAME\n";
+        file << std::string(width_p * height_p, static_cast<char>(yuv[0]));
+        file << std::string(chromaSize, static_cast<char>(yuv[1]));
+        file << std::string(chromaSize, static_cast<char>(yuv[2]));
+    }
+    return path;
+}
+
 TEST(ConnectionTest, WithoutConnectingStateIsNotConnected)
 {
     // arrange & act
@@ -262,6 +293,549 @@ TEST_F(LedStatusTests, SetEveryLedBlinkingWithColorRamp) {
 }
 
 
+TEST_F(LedStatusTests, PlayRedVideo) {
+    // arrange
+    const std::string path{WriteTestY4m("leddisplay_red.y4m", 1280, 720, {{81, 90, 240}, {81, 90, 240}})};
+
+    // act
+    const bool videoStarted{PlayVideo(path.c_str())};
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const bool videoIsPlayingAfterEnd{IsVideoPlaying()};
+    const bool ledIsOnAfterVideo{LedIsOn(10, 10)};
+    std::remove(path.c_str());
+
+    // assert
+    ASSERT_TRUE(videoStarted);
+    ASSERT_FALSE(videoIsPlayingAfterEnd);
+    ASSERT_TRUE(ledIsOnAfterVideo);
+}
+
+
+TEST_F(LedStatusTests, DrawShapesClippedAtBorder) {
+    // arrange
+    int r{0}, g{0}, b{0};
+
+    // act
+    DrawRect(-5, -5, 30, 20, 0, 0, 200);
+    DrawRect(40, 4, 10, 8, 0, 150, 0, true);
+    FillCircle(60, 28, 10, 200, 100, 0);
+    DrawLine(-10, 40, 70, -5, 200, 200, 200);
+    FloodFill(10, 5, 80, 0, 80);
+    LedGetColor(10, 5, r, g, b);
+
+    // assert
+    ASSERT_TRUE(LedIsOn(24, 10));
+    ASSERT_TRUE(LedIsOn(45, 8));
+    ASSERT_TRUE(LedIsOn(63, 31));
+    ASSERT_EQ(r, 80);
+    ASSERT_EQ(g, 0);
+    ASSERT_EQ(b, 80);
+}
+
+// drawing tests - display object only, clipped drawing must match unclipped drawing on a larger display
+constexpr int c_DrawingTestOffset = 100;
+
+static bool IsSameAsCutOut(Display& display_p, Display& largeDisplay_p) {
+    for (int y = 0; y < display_p.GetHeight(); y++) {
+        for (int x = 0; x < display_p.GetWidth(); x++) {
+            const LedColor& color{display_p.GetLed(x, y).GetBaseColor()};
+            if (!(color == largeDisplay_p.GetLed(x + c_DrawingTestOffset, y + c_DrawingTestOffset).GetBaseColor())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TEST(DisplayDrawingTest, ClippedLinesMatchUnclippedLines)
+{
+    // arrange
+    Display display(64, 32);
+    Display largeDisplay(64 + 2 * c_DrawingTestOffset, 32 + 2 * c_DrawingTestOffset);
+    const LedColor color(255, 255, 255);
+    bool allLinesMatch{true};
+
+    // act - lines with endpoints inside and outside, all directions
+    for (int line = 0; line < 2000 && allLinesMatch; line++) {
+        const int x0{(line * 37) % 160 - 50}, y0{(line * 53) % 110 - 40};
+        const int x1{(line * 91) % 170 - 55}, y1{(line * 29) % 100 - 35};
+        display.Clear();
+        largeDisplay.Clear();
+        display.DrawLine(x0, y0, x1, y1, color);
+        largeDisplay.DrawLine(x0 + c_DrawingTestOffset, y0 + c_DrawingTestOffset,
+                              x1 + c_DrawingTestOffset, y1 + c_DrawingTestOffset, color);
+        allLinesMatch = IsSameAsCutOut(display, largeDisplay);
+    }
+
+    // assert
+    ASSERT_TRUE(allLinesMatch);
+}
+
+TEST(DisplayDrawingTest, ClippedRectanglesAndCirclesMatchUnclippedOnes)
+{
+    // arrange
+    Display display(64, 32);
+    Display largeDisplay(64 + 2 * c_DrawingTestOffset, 32 + 2 * c_DrawingTestOffset);
+    const LedColor color(10, 20, 30);
+    bool allShapesMatch{true};
+
+    // act
+    for (int shape = 0; shape < 500 && allShapesMatch; shape++) {
+        const int x{(shape * 37) % 120 - 30}, y{(shape * 53) % 80 - 25};
+        const int width{(shape * 11) % 50}, height{(shape * 7) % 40};
+        display.Clear();
+        largeDisplay.Clear();
+        display.DrawRect(x, y, width, height, color, shape % 2 == 0);
+        largeDisplay.DrawRect(x + c_DrawingTestOffset, y + c_DrawingTestOffset, width, height, color, shape % 2 == 0);
+        display.FillCircle(y, x, width / 2, color);
+        largeDisplay.FillCircle(y + c_DrawingTestOffset, x + c_DrawingTestOffset, width / 2, color);
+        allShapesMatch = IsSameAsCutOut(display, largeDisplay);
+    }
+
+    // assert
+    ASSERT_TRUE(allShapesMatch);
+}
+
+TEST(DisplayDrawingTest, FloodFillStopsAtBorderOfArea)
+{
+    // arrange - rectangle outline with a gap in the left edge
+    Display display(64, 32);
+    const LedColor borderColor(255, 0, 0);
+    const LedColor fillColor(0, 0, 255);
+    display.DrawRect(10, 5, 20, 10, borderColor, false);
+    display.DrawRect(40, 5, 20, 10, borderColor, false);
+    display.GetLed(40, 10).TurnOff();
+
+    // act
+    display.FloodFill(20, 10, fillColor);
+
+    // assert - closed rectangle filled inside only, open one stays as it is
+    ASSERT_TRUE(display.GetLed(11, 6).GetBaseColor() == fillColor);
+    ASSERT_TRUE(display.GetLed(28, 13).GetBaseColor() == fillColor);
+    ASSERT_TRUE(display.GetLed(10, 5).GetBaseColor() == borderColor);
+    ASSERT_FALSE(display.GetLed(5, 5).IsOn());
+    ASSERT_FALSE(display.GetLed(45, 10).IsOn());
+}
+
+TEST(DisplayDrawingTest, ExtremeCoordinatesAreClippedWithoutOverflow)
+{
+    // arrange
+    Display display(64, 32);
+    const LedColor color(1, 2, 3);
+
+    // act
+    display.DrawRect(INT_MAX - 2, 0, 10, 10, color, true);
+    display.DrawRect(INT_MIN, INT_MIN, INT_MAX, INT_MAX, color, false);
+    display.FillCircle(INT_MIN, 10, 3, color);
+    display.FillCircle(INT_MAX, INT_MIN, INT_MAX, color);
+    const bool displayIsEmpty{!display.GetLed(0, 0).IsOn() && !display.GetLed(63, 31).IsOn()};
+    display.FillCircle(10, 10, INT_MAX, color);
+    display.DrawRect(-5, 31, INT_MAX, INT_MAX, color, false);
+
+    Display lineDisplay(64, 32);
+    lineDisplay.DrawLine(INT_MIN, 5, INT_MAX, 6, color);
+    lineDisplay.DrawLine(INT_MIN, INT_MIN, INT_MAX, INT_MAX, color);
+    lineDisplay.DrawLine(-2000000000, 2000000000, 2000000000, 2000000000, color);
+    lineDisplay.DrawLine(INT_MAX, INT_MIN, INT_MAX, INT_MAX, color);
+    const bool lineDisplayHasNoStrayLeds{!lineDisplay.GetLed(0, 31).IsOn() && !lineDisplay.GetLed(63, 0).IsOn()};
+    lineDisplay.DrawLine(-2000000000, -2000000000, 2000000000, 2000000000, color);
+    lineDisplay.DrawLine(40, INT_MIN, 40, INT_MAX, color);
+
+    // assert - huge circle covers the whole display, the rectangle outline is only its top edge in row 31
+    ASSERT_TRUE(displayIsEmpty);
+    ASSERT_TRUE(display.GetLed(0, 0).GetBaseColor() == color);
+    ASSERT_TRUE(display.GetLed(63, 31).GetBaseColor() == color);
+    // lines: nearly horizontal one through the display, the diagonals and a vertical one
+    ASSERT_TRUE(lineDisplayHasNoStrayLeds);
+    ASSERT_TRUE(lineDisplay.GetLed(0, 5).IsOn() || lineDisplay.GetLed(0, 6).IsOn());
+    ASSERT_TRUE(lineDisplay.GetLed(63, 5).IsOn() || lineDisplay.GetLed(63, 6).IsOn());
+    ASSERT_TRUE(lineDisplay.GetLed(5, 5).IsOn());
+    ASSERT_TRUE(lineDisplay.GetLed(31, 31).IsOn());
+    ASSERT_TRUE(lineDisplay.GetLed(40, 0).IsOn());
+    ASSERT_TRUE(lineDisplay.GetLed(40, 31).IsOn());
+}
+
+TEST(DisplayDrawingTest, CheckedAccessOutsideOfDisplayThrows)
+{
+    // arrange
+    Display display(64, 32);
+
+    // act & assert
+    ASSERT_THROW(display.GetLed(64, 0), std::out_of_range);
+    ASSERT_THROW(display.GetLed(0, -1), std::out_of_range);
+    ASSERT_NO_THROW(display.GetLed(63, 31));
+}
+
+// video source tests - scaling and decoding without display
+static bool WaitUntilFinished(VideoSource& videoSource_p) {
+    for (int retry = 0; retry < 100; retry++) {
+        if (videoSource_p.IsFinished()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+TEST(VideoSourceTest, AreaDownscalerAveragesEachBox)
+{
+    // arrange - 4x2 rgb image scaled to 2x1
+    const std::vector<std::uint8_t> image{
+            0, 0, 0,   100, 0, 0,   10, 10, 10,   10, 10, 10,
+            0, 0, 0,   100, 0, 0,   30, 30, 30,   30, 30, 31};
+    AreaDownscaler downscaler(4, 2, 3, 2, 1);
+    std::vector<std::uint8_t> target(6);
+
+    // act
+    downscaler.Scale(image.data(), 12, target.data());
+
+    // assert
+    ASSERT_EQ(target, (std::vector<std::uint8_t>{50, 0, 0, 20, 20, 20}));
+}
+
+TEST(VideoSourceTest, AreaDownscalerHandlesRowsLongerThanVectorWidth)
+{
+    // arrange - gray ramp, every target pixel covers 20x2 pixels
+    const int width{1280}, height{64};
+    std::vector<std::uint8_t> image(width * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            image[y * width + x] = static_cast<std::uint8_t>((x / 20) * 4 + (y % 2));
+        }
+    }
+    AreaDownscaler downscaler(width, height, 1, 64, 32);
+    std::vector<std::uint8_t> target(64 * 32);
+
+    // act
+    downscaler.Scale(image.data(), width, target.data());
+
+    // assert - average of +0 and +1 is rounded up
+    for (int x = 0; x < 64; x++) {
+        ASSERT_EQ(target[31 * 64 + x], x * 4 + 1);
+    }
+}
+
+TEST(VideoSourceTest, Y4mIsDecodedToRgbInPanelResolution)
+{
+    // arrange - limited range white, then gray
+    const std::string path{WriteTestY4m("leddisplay_gray.y4m", 320, 180, {{235, 128, 128}, {126, 128, 128}})};
+    VideoSource videoSource(64, 32);
+    FrameBuffer firstFrame, secondFrame;
+
+    // act
+    const bool opened{videoSource.Open(path, eVideoFormatY4m)};
+    bool firstFrameAvailable{false}, secondFrameAvailable{false};
+    for (int retry = 0; retry < 100 && !firstFrameAvailable; retry++) {
+        firstFrameAvailable = videoSource.GetFrameForTime(1000, firstFrame);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const bool secondFrameTooEarly{videoSource.GetFrameForTime(1010, secondFrame)};
+    for (int retry = 0; retry < 100 && !secondFrameAvailable; retry++) {
+        secondFrameAvailable = videoSource.GetFrameForTime(1040, secondFrame);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::remove(path.c_str());
+
+    // assert
+    ASSERT_TRUE(opened);
+    ASSERT_TRUE(firstFrameAvailable);
+    ASSERT_FALSE(secondFrameTooEarly);
+    ASSERT_TRUE(secondFrameAvailable);
+    ASSERT_EQ(firstFrame.size(), 3u * 64 * 32);
+    ASSERT_EQ(firstFrame[0], 255);
+    ASSERT_EQ(secondFrame[3 * 100 + 1], 128);
+    ASSERT_TRUE(videoSource.IsFinished());
+}
+
+TEST(VideoSourceTest, HighFrameRateVideoKeepsUpWithPlaybackTime)
+{
+    // arrange - 1s at 240 fps, more frames per render cycle than the prefetch queue holds
+    const std::vector<std::vector<int>> frames(240, {126, 128, 128});
+    const std::string path{WriteTestY4m("leddisplay_240fps.y4m", 160, 90, frames, "F240:1")};
+    VideoSource videoSource(64, 32);
+    FrameBuffer frame;
+    const auto start = std::chrono::steady_clock::now();
+
+    // act - poll like the cyclic loop does
+    const bool opened{videoSource.Open(path, eVideoFormatY4m)};
+    long playbackDurationInMs{0};
+    while (opened && !videoSource.IsFinished() && playbackDurationInMs < 5000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        playbackDurationInMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        videoSource.GetFrameForTime(playbackDurationInMs, frame);
+    }
+    std::remove(path.c_str());
+
+    // assert
+    ASSERT_TRUE(opened);
+    ASSERT_LT(playbackDurationInMs, 1500);
+}
+
+TEST(VideoSourceTest, OpeningNonY4mInputFails)
+{
+    // arrange
+    const std::string path{testing::TempDir() + "leddisplay_no_video.y4m"};
+    std::ofstream(path) << "no video";
+    VideoSource videoSource(64, 32);
+
+    // act - header is checked on the decode thread
+    const bool opened{videoSource.Open(path, eVideoFormatY4m)};
+    const bool finished{WaitUntilFinished(videoSource)};
+    std::remove(path.c_str());
+
+    // assert
+    ASSERT_TRUE(opened);
+    ASSERT_TRUE(finished);
+    ASSERT_FALSE(videoSource.GetErrorText().empty());
+}
+
+TEST(VideoSourceTest, OpeningY4mWithMoreThan8BitFails)
+{
+    // arrange
+    const std::string path{testing::TempDir() + "leddisplay_10bit.y4m"};
+    std::ofstream(path) << "YUV4MPEG2 W64 H32 F25:1 C420p10\nFRAME\n";
+    VideoSource videoSource(64, 32);
+
+    // act
+    const bool opened{videoSource.Open(path, eVideoFormatY4m)};
+    const bool finished{WaitUntilFinished(videoSource)};
+    std::remove(path.c_str());
+
+    // assert
+    ASSERT_TRUE(opened);
+    ASSERT_TRUE(finished);
+    ASSERT_NE(videoSource.GetErrorText().find("C420p10"), std::string::npos);
+}
+
+TEST(VideoSourceTest, OpeningY4mWithImplausibleSizeFails)
+{
+    // arrange
+    const std::string path{testing::TempDir() + "leddisplay_huge.y4m"};
+    std::ofstream(path) << "YUV4MPEG2 W2000000000 H2000000000 F25:1\nFRAME\n";
+    VideoSource videoSource(64, 32);
+    VideoSource rawVideoSource(64, 32);
+
+    // act
+    const bool opened{videoSource.Open(path, eVideoFormatY4m)};
+    const bool finished{WaitUntilFinished(videoSource)};
+    const bool rawOpened{rawVideoSource.Open(path, eVideoFormatRawRgb, 100000, 100000)};
+    std::remove(path.c_str());
+
+    // assert
+    ASSERT_TRUE(opened);
+    ASSERT_TRUE(finished);
+    ASSERT_FALSE(videoSource.GetErrorText().empty());
+    ASSERT_FALSE(rawOpened);
+    ASSERT_FALSE(rawVideoSource.GetErrorText().empty());
+}
+
+TEST(VideoSourceTest, OpenAndStopDoNotBlockOnIdlePipe)
+{
+    // arrange - fifo without writer
+    const std::string path{testing::TempDir() + "leddisplay_idle.fifo"};
+    std::remove(path.c_str());
+    ASSERT_EQ(mkfifo(path.c_str(), 0600), 0);
+    VideoSource videoSource(64, 32);
+    const auto start = std::chrono::steady_clock::now();
+
+    // act
+    const bool opened{videoSource.Open(path, eVideoFormatY4m)};
+    videoSource.Stop();
+    const auto durationInMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::remove(path.c_str());
+
+    // assert
+    ASSERT_TRUE(opened);
+    ASSERT_LT(durationInMs, 1000);
+}
+
+// frame transport tests - encoder and decoder without display
+constexpr int c_TransportTestNumberOfLeds = 64 * 32;
+
+TEST(FrameTransportTest, KeyFrameOfBlackFrameIsSmallAndDecodesToBlack)
+{
+    // arrange
+    FrameEncoder encoder(c_TransportTestNumberOfLeds);
+    FrameDecoder decoder(c_TransportTestNumberOfLeds);
+    const FrameBuffer blackFrame(3 * c_TransportTestNumberOfLeds, 0);
+
+    // act
+    const PacketBuffer packet{encoder.EncodeFrame(blackFrame)};
+    const int completedFrames{decoder.ProcessIncoming(packet.data(), packet.size())};
+
+    // assert
+    ASSERT_LT(packet.size(), 20u);
+    ASSERT_EQ(completedFrames, 1);
+    ASSERT_EQ(decoder.GetFrame(), blackFrame);
+}
+
+TEST(FrameTransportTest, DeltaFrameOnlyContainsChangedLeds)
+{
+    // arrange
+    FrameEncoder encoder(c_TransportTestNumberOfLeds);
+    FrameDecoder decoder(c_TransportTestNumberOfLeds);
+    FrameBuffer frame(3 * c_TransportTestNumberOfLeds, 0);
+    for (std::size_t index = 0; index < frame.size(); index++) {
+        frame[index] = static_cast<std::uint8_t>(index * 7);
+    }
+
+    // act
+    const PacketBuffer keyFrame{encoder.EncodeFrame(frame)};
+    frame[3 * 100] = 255;
+    frame[3 * 1000 + 2] = 1;
+    const PacketBuffer deltaFrame{encoder.EncodeFrame(frame)};
+    decoder.ProcessIncoming(keyFrame.data(), keyFrame.size());
+    decoder.ProcessIncoming(deltaFrame.data(), deltaFrame.size());
+
+    // assert
+    ASSERT_GT(keyFrame.size(), frame.size());
+    ASSERT_LT(deltaFrame.size(), 40u);
+    ASSERT_EQ(decoder.GetNumberOfDecodedFrames(), 2);
+    ASSERT_EQ(decoder.GetFrame(), frame);
+}
+
+TEST(FrameTransportTest, CorruptPacketIsDroppedAndDecoderResyncs)
+{
+    // arrange
+    FrameEncoder encoder(c_TransportTestNumberOfLeds, 2);
+    FrameDecoder decoder(c_TransportTestNumberOfLeds);
+    FrameBuffer frame(3 * c_TransportTestNumberOfLeds, 0);
+
+    // act - second frame gets corrupted, third (delta on lost frame) is dropped, fourth is a key frame again
+    PacketBuffer stream;
+    for (int frameNumber = 0; frameNumber < 4; frameNumber++) {
+        frame[3 * frameNumber] = static_cast<std::uint8_t>(10 + frameNumber);
+        PacketBuffer packet{encoder.EncodeFrame(frame)};
+        if (frameNumber == 1) {
+            packet[packet.size() / 2] ^= 0xFF;
+        }
+        stream.insert(stream.end(), packet.begin(), packet.end());
+    }
+    decoder.ProcessIncoming(stream.data(), stream.size());
+
+    // assert
+    ASSERT_EQ(decoder.GetNumberOfDecodedFrames(), 2);
+    ASSERT_EQ(decoder.GetNumberOfDroppedPackets(), 1);
+    ASSERT_GT(decoder.GetNumberOfDroppedBytes(), 0);
+    ASSERT_EQ(decoder.GetFrame(), frame);
+}
+
+TEST(FrameTransportTest, FalseHeaderInStreamDoesNotStallResync)
+{
+    // arrange - frame header start as it can show up in pixel data, claiming the maximum number of spans
+    FrameEncoder encoder(c_TransportTestNumberOfLeds);
+    FrameDecoder decoder(c_TransportTestNumberOfLeds);
+    FrameBuffer frame(3 * c_TransportTestNumberOfLeds, 0);
+    PacketBuffer stream{'L', 'D', eKeyFrame, 0, 0, 0, 0,
+                        c_TransportTestNumberOfLeds & 0xFF, c_TransportTestNumberOfLeds >> 8,
+                        c_TransportTestNumberOfLeds & 0xFF, c_TransportTestNumberOfLeds >> 8};
+    const std::size_t falseHeaderLength{stream.size()};
+
+    // act
+    for (int frameNumber = 0; frameNumber < 50; frameNumber++) {
+        frame[3 * frameNumber] = static_cast<std::uint8_t>(76 + frameNumber);
+        const PacketBuffer packet{encoder.EncodeFrame(frame)};
+        stream.insert(stream.end(), packet.begin(), packet.end());
+    }
+    decoder.ProcessIncoming(stream.data(), stream.size());
+
+    // assert
+    ASSERT_EQ(decoder.GetNumberOfDecodedFrames(), 50);
+    ASSERT_EQ(decoder.GetNumberOfDroppedBytes(), static_cast<long>(falseHeaderLength));
+    ASSERT_EQ(decoder.GetFrame(), frame);
+}
+
+TEST(FrameTransportTest, PacketForOtherNumberOfLedsIsIgnored)
+{
+    // arrange
+    FrameEncoder encoder(c_TransportTestNumberOfLeds / 2);
+    FrameDecoder decoder(c_TransportTestNumberOfLeds);
+    const FrameBuffer frame(3 * c_TransportTestNumberOfLeds / 2, 0);
+
+    // act
+    const PacketBuffer packet{encoder.EncodeFrame(frame)};
+    decoder.ProcessIncoming(packet.data(), packet.size());
+
+    // assert
+    ASSERT_EQ(decoder.GetNumberOfDecodedFrames(), 0);
+    ASSERT_GT(decoder.GetNumberOfDroppedBytes(), 0);
+}
+
+TEST(FrameTransportTest, WithAcknowledgesDeltasAreBuiltOnAcknowledgedFrame)
+{
+    // arrange
+    FrameEncoder encoder(c_TransportTestNumberOfLeds, 100, true);
+    FrameDecoder decoder(c_TransportTestNumberOfLeds);
+    FrameBuffer frame(3 * c_TransportTestNumberOfLeds, 0);
+
+    // act - acknowledge of first frame arrives only after the second frame has been sent
+    frame[0] = 1;
+    const PacketBuffer firstFrame{encoder.EncodeFrame(frame)};
+    decoder.ProcessIncoming(firstFrame.data(), firstFrame.size());
+    frame[3] = 2;
+    const PacketBuffer secondFrame{encoder.EncodeFrame(frame)};
+    const PacketBuffer acknowledges{decoder.TakeOutgoing()};
+    encoder.ProcessIncoming(acknowledges.data(), acknowledges.size());
+    frame[0] = 0;
+    const PacketBuffer thirdFrame{encoder.EncodeFrame(frame)};
+    decoder.ProcessIncoming(secondFrame.data(), secondFrame.size());
+    decoder.ProcessIncoming(thirdFrame.data(), thirdFrame.size());
+
+    // assert
+    ASSERT_EQ(decoder.GetNumberOfDecodedFrames(), 3);
+    ASSERT_EQ(decoder.GetNumberOfDroppedPackets(), 0);
+    ASSERT_EQ(decoder.GetFrame(), frame);
+}
+
+// hardware link tests - library connected to a socket, the test plays the receiver
+TEST(HardwareLinkTest, FramesAreReceivedAndClosedLinkIsDisabled)
+{
+    // arrange
+    int sockets[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+    FrameDecoder decoder(c_TransportTestNumberOfLeds);
+    Connect(true);
+    SetHardwareLink(sockets[0], true);
+
+    // act - receive frames and acknowledge them until the drawn leds show up
+    LedOn(3, 4, 200, 100, 50);
+    DrawRect(10, 10, 5, 5, 0, 255, 0, true);
+    bool frameReceived{false};
+    const auto start = std::chrono::steady_clock::now();
+    while (!frameReceived && std::chrono::steady_clock::now() - start < std::chrono::seconds(2)) {
+        pollfd pollFileDescriptor{sockets[1], POLLIN, 0};
+        if (poll(&pollFileDescriptor, 1, 100) <= 0) {
+            continue;
+        }
+        std::uint8_t receiveBuffer[4096];
+        const ssize_t bytesRead{read(sockets[1], receiveBuffer, sizeof(receiveBuffer))};
+        ASSERT_GT(bytesRead, 0);
+        decoder.ProcessIncoming(receiveBuffer, static_cast<std::size_t>(bytesRead));
+        const PacketBuffer acknowledges{decoder.TakeOutgoing()};
+        ASSERT_EQ(write(sockets[1], acknowledges.data(), acknowledges.size()), static_cast<ssize_t>(acknowledges.size()));
+        frameReceived = decoder.HasFrame() && decoder.GetFrame()[3 * (4 * 64 + 3)] == 200
+                        && decoder.GetFrame()[3 * (12 * 64 + 12) + 1] == 255;
+    }
+    const FrameBuffer frame{frameReceived ? decoder.GetFrame() : FrameBuffer()};
+
+    // act - receiver goes away, the next write must disable the link instead of raising SIGPIPE
+    testing::internal::CaptureStdout();
+    close(sockets[1]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    const std::string debugOutput{testing::internal::GetCapturedStdout()};
+    Disconnect();
+    SetHardwareLink(-1);
+    close(sockets[0]);
+
+    // assert
+    ASSERT_TRUE(frameReceived);
+    ASSERT_EQ(frame[3 * (4 * 64 + 3) + 1], 100);
+    ASSERT_EQ(frame[3 * (4 * 64 + 3) + 2], 50);
+    ASSERT_EQ(frame[0], 0);
+    ASSERT_NE(debugOutput.find("link is disabled"), std::string::npos);
+}
+
+
 int main(int argc, char *argv[])
 {
     testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,450 @@
+#include "frametransport.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// constants of the packet format
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+constexpr std::uint8_t c_MagicFirstByte = 'L';
+constexpr std::uint8_t c_MagicSecondByte = 'D';
+
+constexpr std::size_t c_ControlPacketLength = 9;       // magic, type, sequence, crc
+constexpr std::size_t c_FrameHeaderLength = 11;        // magic, type, sequence, reference, led count, span count
+constexpr std::size_t c_SpanHeaderLength = 4;
+constexpr std::size_t c_CrcLength = 4;
+
+constexpr std::uint16_t c_RunFlag = 0x8000;
+constexpr int c_MaxSpanLengthInLeds = 0x7FFF;
+
+// a run span (4 + 3 bytes) in the middle of literal data costs an additional span header,
+// so it only pays off for some identical leds in a row
+constexpr int c_MinRunLengthInLeds = 4;
+// an unchanged led inside a span costs 3 bytes, a new span header 4 bytes
+constexpr int c_MaxBridgedGapInLeds = 1;
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// (static) helper routines
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+static void PutUint16(PacketBuffer& packet_p, std::uint16_t value_p) {
+    packet_p.push_back(static_cast<std::uint8_t>(value_p & 0xFF));
+    packet_p.push_back(static_cast<std::uint8_t>(value_p >> 8));
+}
+
+static void PutUint32(PacketBuffer& packet_p, std::uint32_t value_p) {
+    PutUint16(packet_p, static_cast<std::uint16_t>(value_p & 0xFFFF));
+    PutUint16(packet_p, static_cast<std::uint16_t>(value_p >> 16));
+}
+
+static void SetUint16(PacketBuffer& packet_p, std::size_t position_p, std::uint16_t value_p) {
+    packet_p[position_p] = static_cast<std::uint8_t>(value_p & 0xFF);
+    packet_p[position_p + 1] = static_cast<std::uint8_t>(value_p >> 8);
+}
+
+static std::uint16_t GetUint16(const std::uint8_t* data_p) {
+    return static_cast<std::uint16_t>(data_p[0] | (data_p[1] << 8));
+}
+
+static std::uint32_t GetUint32(const std::uint8_t* data_p) {
+    return GetUint16(data_p) | (static_cast<std::uint32_t>(GetUint16(data_p + 2)) << 16);
+}
+
+static void AppendCrc(PacketBuffer& packet_p, std::size_t packetStart_p) {
+    PutUint32(packet_p, Crc32(packet_p.data() + packetStart_p, packet_p.size() - packetStart_p));
+}
+
+static void AppendControlPacket(PacketBuffer& packet_p, PacketType type_p, std::uint16_t sequence_p) {
+    const std::size_t packetStart{packet_p.size()};
+    packet_p.push_back(c_MagicFirstByte);
+    packet_p.push_back(c_MagicSecondByte);
+    packet_p.push_back(type_p);
+    PutUint16(packet_p, sequence_p);
+    AppendCrc(packet_p, packetStart);
+}
+
+static bool IsSameColor(const std::uint8_t* frame_p, int firstLed_p, int secondLed_p) {
+    return std::memcmp(frame_p + 3 * firstLed_p, frame_p + 3 * secondLed_p, 3) == 0;
+}
+
+// number of leds starting at startLed_p having the same color (at least 1)
+static int RunLength(const std::uint8_t* frame_p, int startLed_p, int endLed_p) {
+    int led{startLed_p + 1};
+    while (led < endLed_p && IsSameColor(frame_p, startLed_p, led)) {
+        led++;
+    }
+    return led - startLed_p;
+}
+
+std::uint32_t Crc32(const std::uint8_t* data_p, std::size_t size_p) {
+    static const std::array<std::uint32_t, 256> crcTable = [] {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t index = 0; index < 256; index++) {
+            std::uint32_t crc{index};
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            table[index] = crc;
+        }
+        return table;
+    }();
+
+    std::uint32_t crc{0xFFFFFFFFu};
+    for (std::size_t index = 0; index < size_p; index++) {
+        crc = crcTable[(crc ^ data_p[index]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// packet parser
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+void PacketParser::Append(const std::uint8_t* data_p, std::size_t size_p) {
+    // drop already parsed bytes before the buffer grows
+    if (m_ReadPosition > 0) {
+        m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + m_ReadPosition);
+        m_ReadPosition = 0;
+    }
+    m_Buffer.insert(m_Buffer.end(), data_p, data_p + size_p);
+}
+
+long PacketParser::PacketLengthAtReadPosition() const {
+    const std::uint8_t* packet{m_Buffer.data() + m_ReadPosition};
+    const std::size_t available{m_Buffer.size() - m_ReadPosition};
+
+    if (available < 3) {
+        return 0;
+    }
+    if (packet[0] != c_MagicFirstByte || packet[1] != c_MagicSecondByte) {
+        return -1;
+    }
+
+    switch (packet[2]) {
+        case eAcknowledge:
+        case eKeyFrameRequest:
+            return available < c_ControlPacketLength ? 0 : static_cast<long>(c_ControlPacketLength);
+        case eKeyFrame:
+        case eDeltaFrame:
+            break;
+        default:
+            return -1;
+    }
+
+    if (available < c_FrameHeaderLength) {
+        return 0;
+    }
+    const int ledCount{GetUint16(packet + 7)};
+    const int spanCount{GetUint16(packet + 9)};
+    if (ledCount != m_NumberOfLeds || spanCount > ledCount) {
+        return -1;
+    }
+
+    // walk over the spans to find the end of the packet, implausible spans mark a corrupt header
+    // spans have to be ascending and must not overlap, so a false header found while resyncing
+    // can not claim more than a worst case frame of this led count
+    std::size_t length{c_FrameHeaderLength};
+    int spansEnd{0};
+    for (int span = 0; span < spanCount; span++) {
+        if (available < length + c_SpanHeaderLength) {
+            return 0;
+        }
+        const int offset{GetUint16(packet + length)};
+        const std::uint16_t lengthField{GetUint16(packet + length + 2)};
+        const int spanLength{lengthField & c_MaxSpanLengthInLeds};
+        if (spanLength == 0 || offset < spansEnd || offset + spanLength > ledCount) {
+            return -1;
+        }
+        spansEnd = offset + spanLength;
+        length += c_SpanHeaderLength + ((lengthField & c_RunFlag) ? 3 : 3 * spanLength);
+    }
+    length += c_CrcLength;
+
+    return available < length ? 0 : static_cast<long>(length);
+}
+
+bool PacketParser::NextPacket(Packet& packet_p) {
+    while (true) {
+        const long length{PacketLengthAtReadPosition()};
+        if (length == 0) {
+            return false;
+        }
+
+        const std::uint8_t* packet{m_Buffer.data() + m_ReadPosition};
+        if (length < 0 || Crc32(packet, length - c_CrcLength) != GetUint32(packet + length - c_CrcLength)) {
+            // resync on the next byte
+            m_ReadPosition++;
+            m_DroppedBytes++;
+            continue;
+        }
+
+        packet_p.m_Type = static_cast<PacketType>(packet[2]);
+        packet_p.m_Sequence = GetUint16(packet + 3);
+        if (packet_p.m_Type == eKeyFrame || packet_p.m_Type == eDeltaFrame) {
+            packet_p.m_ReferenceSequence = GetUint16(packet + 5);
+            packet_p.m_LedCount = GetUint16(packet + 7);
+            packet_p.m_SpanCount = GetUint16(packet + 9);
+            packet_p.m_Spans.assign(packet + c_FrameHeaderLength, packet + length - c_CrcLength);
+        } else {
+            packet_p.m_ReferenceSequence = 0;
+            packet_p.m_LedCount = 0;
+            packet_p.m_SpanCount = 0;
+            packet_p.m_Spans.clear();
+        }
+
+        m_ReadPosition += length;
+        return true;
+    }
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// frame encoder
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+FrameEncoder::FrameEncoder(int numberOfLeds_p, int keyFrameIntervalInFrames_p, bool waitForAcknowledge_p)
+        : m_NumberOfLeds{numberOfLeds_p}, m_KeyFrameInterval{keyFrameIntervalInFrames_p},
+          m_WaitForAcknowledge{waitForAcknowledge_p}, m_Parser{numberOfLeds_p} {
+    if (numberOfLeds_p <= 0 || numberOfLeds_p > 0xFFFF) {
+        throw std::invalid_argument("FrameEncoder: number of leds must be within 1..65535");
+    }
+}
+
+PacketBuffer FrameEncoder::EncodeFrame(const FrameBuffer& frame_p) {
+    if (frame_p.size() != static_cast<std::size_t>(3 * m_NumberOfLeds)) {
+        throw std::invalid_argument("FrameEncoder: frame size does not match number of leds");
+    }
+
+    const std::uint16_t sequence{m_NextSequence++};
+    // the receiver only keeps a limited number of frames as reference for deltas
+    const bool isKeyFrame{m_KeyFrameRequested || !m_HasReference
+                          || m_FramesSinceKeyFrame >= m_KeyFrameInterval
+                          || static_cast<std::uint16_t>(sequence - m_ReferenceSequence) >= c_FrameHistoryDepth};
+
+    // a key frame is the delta against a black frame
+    FrameBuffer blackFrame;
+    if (isKeyFrame) {
+        blackFrame.assign(frame_p.size(), 0);
+    }
+    const std::uint8_t* reference{isKeyFrame ? blackFrame.data() : m_ReferenceFrame.data()};
+    const std::uint8_t* frame{frame_p.data()};
+
+    PacketBuffer packet;
+    packet.push_back(c_MagicFirstByte);
+    packet.push_back(c_MagicSecondByte);
+    packet.push_back(isKeyFrame ? eKeyFrame : eDeltaFrame);
+    PutUint16(packet, sequence);
+    PutUint16(packet, isKeyFrame ? 0 : m_ReferenceSequence);
+    PutUint16(packet, static_cast<std::uint16_t>(m_NumberOfLeds));
+    PutUint16(packet, 0); // span count, filled in below
+
+    auto isChanged = [frame, reference](int led_p) {
+        return std::memcmp(frame + 3 * led_p, reference + 3 * led_p, 3) != 0;
+    };
+
+    std::uint16_t spanCount{0};
+    int led{0};
+    while (led < m_NumberOfLeds) {
+        if (!isChanged(led)) {
+            led++;
+            continue;
+        }
+        // extend region of changed leds, small gaps of unchanged leds are cheaper to send along
+        int regionEnd{led + 1};
+        for (int next = regionEnd; next < m_NumberOfLeds && next - regionEnd <= c_MaxBridgedGapInLeds; next++) {
+            if (isChanged(next)) {
+                regionEnd = next + 1;
+            }
+        }
+        AppendSpans(packet, frame, led, regionEnd, spanCount);
+        led = regionEnd;
+    }
+    SetUint16(packet, 9, spanCount);
+    AppendCrc(packet, 0);
+
+    if (isKeyFrame) {
+        m_FramesSinceKeyFrame = 0;
+        m_KeyFrameRequested = false;
+    } else {
+        m_FramesSinceKeyFrame++;
+    }
+
+    if (m_WaitForAcknowledge) {
+        m_UnacknowledgedFrames.emplace_back(sequence, frame_p);
+        while (m_UnacknowledgedFrames.size() > c_FrameHistoryDepth) {
+            m_UnacknowledgedFrames.pop_front();
+        }
+    } else {
+        m_HasReference = true;
+        m_ReferenceSequence = sequence;
+        m_ReferenceFrame = frame_p;
+    }
+
+    return packet;
+}
+
+void FrameEncoder::AppendSpans(PacketBuffer& packet_p, const std::uint8_t* frame_p, int begin_p, int end_p,
+                               std::uint16_t& spanCount_p) const {
+    int led{begin_p};
+    while (led < end_p) {
+        const int runLength{RunLength(frame_p, led, end_p)};
+        if (runLength >= c_MinRunLengthInLeds) {
+            const int spanLength{std::min(runLength, c_MaxSpanLengthInLeds)};
+            PutUint16(packet_p, static_cast<std::uint16_t>(led));
+            PutUint16(packet_p, static_cast<std::uint16_t>(spanLength | c_RunFlag));
+            packet_p.insert(packet_p.end(), frame_p + 3 * led, frame_p + 3 * led + 3);
+            spanCount_p++;
+            led += spanLength;
+            continue;
+        }
+
+        // literal span up to the next run that is worth its own span
+        int literalEnd{led + runLength};
+        while (literalEnd < end_p && literalEnd - led < c_MaxSpanLengthInLeds) {
+            const int nextRunLength{RunLength(frame_p, literalEnd, end_p)};
+            if (nextRunLength >= c_MinRunLengthInLeds) {
+                break;
+            }
+            literalEnd += nextRunLength;
+        }
+        literalEnd = std::min(literalEnd, led + c_MaxSpanLengthInLeds);
+
+        PutUint16(packet_p, static_cast<std::uint16_t>(led));
+        PutUint16(packet_p, static_cast<std::uint16_t>(literalEnd - led));
+        packet_p.insert(packet_p.end(), frame_p + 3 * led, frame_p + 3 * literalEnd);
+        spanCount_p++;
+        led = literalEnd;
+    }
+}
+
+void FrameEncoder::ProcessIncoming(const std::uint8_t* data_p, std::size_t size_p) {
+    m_Parser.Append(data_p, size_p);
+
+    Packet packet;
+    while (m_Parser.NextPacket(packet)) {
+        if (packet.m_Type == eAcknowledge) {
+            Acknowledge(packet.m_Sequence);
+        } else if (packet.m_Type == eKeyFrameRequest) {
+            m_KeyFrameRequested = true;
+            if (m_WaitForAcknowledge) {
+                // keep sending key frames until one of them is acknowledged
+                m_HasReference = false;
+            }
+        }
+    }
+}
+
+void FrameEncoder::Acknowledge(std::uint16_t sequence_p) {
+    auto acknowledgedFrame = std::find_if(m_UnacknowledgedFrames.begin(), m_UnacknowledgedFrames.end(),
+                                          [sequence_p](const std::pair<std::uint16_t, FrameBuffer>& entry_p) {
+                                              return entry_p.first == sequence_p;
+                                          });
+    if (acknowledgedFrame == m_UnacknowledgedFrames.end()) {
+        // already superseded by a newer acknowledge
+        return;
+    }
+
+    m_HasReference = true;
+    m_ReferenceSequence = acknowledgedFrame->first;
+    m_ReferenceFrame = std::move(acknowledgedFrame->second);
+    m_UnacknowledgedFrames.erase(m_UnacknowledgedFrames.begin(), acknowledgedFrame + 1);
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// frame decoder
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+FrameDecoder::FrameDecoder(int numberOfLeds_p) : m_NumberOfLeds{numberOfLeds_p}, m_Parser{numberOfLeds_p} {
+    if (numberOfLeds_p <= 0 || numberOfLeds_p > 0xFFFF) {
+        throw std::invalid_argument("FrameDecoder: number of leds must be within 1..65535");
+    }
+}
+
+int FrameDecoder::ProcessIncoming(const std::uint8_t* data_p, std::size_t size_p) {
+    m_Parser.Append(data_p, size_p);
+
+    int completedFrames{0};
+    Packet packet;
+    while (m_Parser.NextPacket(packet)) {
+        if (packet.m_Type != eKeyFrame && packet.m_Type != eDeltaFrame) {
+            continue;
+        }
+        if (packet.m_LedCount != m_NumberOfLeds) {
+            m_DroppedPackets++;
+            continue;
+        }
+
+        FrameBuffer frame;
+        if (packet.m_Type == eKeyFrame) {
+            frame.assign(3 * m_NumberOfLeds, 0);
+        } else {
+            auto reference = std::find_if(m_History.rbegin(), m_History.rend(),
+                                          [&packet](const std::pair<std::uint16_t, FrameBuffer>& entry_p) {
+                                              return entry_p.first == packet.m_ReferenceSequence;
+                                          });
+            if (reference == m_History.rend()) {
+                m_DroppedPackets++;
+                if (!m_KeyFrameRequested) {
+                    AppendControlPacket(m_Outgoing, eKeyFrameRequest, packet.m_Sequence);
+                    m_KeyFrameRequested = true;
+                }
+                continue;
+            }
+            frame = reference->second;
+        }
+
+        if (!ApplySpans(packet, frame)) {
+            m_DroppedPackets++;
+            continue;
+        }
+        if (packet.m_Type == eKeyFrame) {
+            m_KeyFrameRequested = false;
+        }
+
+        m_History.emplace_back(packet.m_Sequence, std::move(frame));
+        while (m_History.size() > c_FrameHistoryDepth) {
+            m_History.pop_front();
+        }
+        AppendControlPacket(m_Outgoing, eAcknowledge, packet.m_Sequence);
+        m_DecodedFrames++;
+        completedFrames++;
+    }
+
+    return completedFrames;
+}
+
+bool FrameDecoder::ApplySpans(const Packet& packet_p, FrameBuffer& frame_p) const {
+    const std::uint8_t* span{packet_p.m_Spans.data()};
+    const std::uint8_t* spansEnd{span + packet_p.m_Spans.size()};
+
+    for (int spanIndex = 0; spanIndex < packet_p.m_SpanCount; spanIndex++) {
+        if (spansEnd - span < static_cast<long>(c_SpanHeaderLength)) {
+            return false;
+        }
+        const int offset{GetUint16(span)};
+        const std::uint16_t lengthField{GetUint16(span + 2)};
+        const int spanLength{lengthField & c_MaxSpanLengthInLeds};
+        const bool isRun{(lengthField & c_RunFlag) != 0};
+        span += c_SpanHeaderLength;
+
+        const long dataLength{isRun ? 3 : 3L * spanLength};
+        if (offset + spanLength > m_NumberOfLeds || spansEnd - span < dataLength) {
+            return false;
+        }
+
+        std::uint8_t* target{frame_p.data() + 3 * offset};
+        if (isRun) {
+            for (int led = 0; led < spanLength; led++) {
+                std::memcpy(target + 3 * led, span, 3);
+            }
+        } else {
+            std::memcpy(target, span, dataLength);
+        }
+        span += dataLength;
+    }
+
+    return span == spansEnd;
+}
+
+PacketBuffer FrameDecoder::TakeOutgoing() {
+    PacketBuffer outgoing;
+    outgoing.swap(m_Outgoing);
+    return outgoing;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// frame transport for the (bandwidth limited) serial link to the display
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+// a frame is 8 bit rgb per led, row by row (3 bytes per led)
+using FrameBuffer = std::vector<std::uint8_t>;
+using PacketBuffer = std::vector<std::uint8_t>;
+
+// Packet layout (multi byte values are little endian):
+//   'L' 'D' | type (1) | sequence (2) | [reference sequence (2) | led count (2) | span count (2) | spans] | crc32 (4)
+// The part in brackets is only present for key and delta frames. A span is
+//   offset in leds (2) | length in leds (2) | rgb data
+// If the top bit of the length is set, the span is a run of one color (3 bytes of rgb data),
+// otherwise it carries 3 bytes of rgb data per led.
+enum PacketType : std::uint8_t {
+    eKeyFrame = 1,          // complete frame, starts from black
+    eDeltaFrame = 2,        // changed spans against the frame with the reference sequence
+    eAcknowledge = 3,       // receiver -> sender: frame with sequence has been applied
+    eKeyFrameRequest = 4    // receiver -> sender: reference frame missing, please send a key frame
+};
+
+// number of decoded frames the receiver keeps as possible delta references
+constexpr int c_FrameHistoryDepth = 8;
+
+struct Packet {
+    PacketType m_Type = eKeyFrame;
+    std::uint16_t m_Sequence = 0;
+    std::uint16_t m_ReferenceSequence = 0;
+    std::uint16_t m_LedCount = 0;
+    std::uint16_t m_SpanCount = 0;
+    std::vector<std::uint8_t> m_Spans;
+};
+
+std::uint32_t Crc32(const std::uint8_t* data_p, std::size_t size_p);
+
+// collects received bytes and cuts them into checked packets, garbage and corrupt packets are skipped
+// frame packets for another number of leds are treated as garbage
+class PacketParser {
+public:
+    explicit PacketParser(int numberOfLeds_p) : m_NumberOfLeds{numberOfLeds_p} {}
+
+    void Append(const std::uint8_t* data_p, std::size_t size_p);
+    // returns false if no further complete packet is available
+    bool NextPacket(Packet& packet_p);
+
+    long GetNumberOfDroppedBytes() const {return m_DroppedBytes;}
+
+private:
+    // returns length of packet at m_ReadPosition, 0 if incomplete, -1 if no valid packet starts here
+    long PacketLengthAtReadPosition() const;
+
+    int m_NumberOfLeds;
+    std::vector<std::uint8_t> m_Buffer;
+    std::size_t m_ReadPosition = 0;
+    long m_DroppedBytes = 0;
+};
+
+// sender side: diffs each frame against the last acknowledged one and emits key / delta frame packets
+class FrameEncoder {
+public:
+    // without acknowledges (e.g. pipe or one way serial line) each sent frame is assumed to be received
+    FrameEncoder(int numberOfLeds_p, int keyFrameIntervalInFrames_p = 100, bool waitForAcknowledge_p = false);
+
+    PacketBuffer EncodeFrame(const FrameBuffer& frame_p);
+    // acknowledges and key frame requests coming back from the receiver
+    void ProcessIncoming(const std::uint8_t* data_p, std::size_t size_p);
+    // e.g. after a failed write - the receiver can not be in sync anymore
+    void RequestKeyFrame() {m_KeyFrameRequested = true;}
+
+private:
+    void Acknowledge(std::uint16_t sequence_p);
+    void AppendSpans(PacketBuffer& packet_p, const std::uint8_t* frame_p, int begin_p, int end_p, std::uint16_t& spanCount_p) const;
+
+    int m_NumberOfLeds;
+    int m_KeyFrameInterval;
+    bool m_WaitForAcknowledge;
+
+    std::uint16_t m_NextSequence = 0;
+    int m_FramesSinceKeyFrame = 0;
+    bool m_KeyFrameRequested = true;
+
+    // frame the receiver is known to have
+    bool m_HasReference = false;
+    std::uint16_t m_ReferenceSequence = 0;
+    FrameBuffer m_ReferenceFrame;
+    // frames sent but not yet acknowledged (only used when waiting for acknowledges)
+    std::deque<std::pair<std::uint16_t, FrameBuffer>> m_UnacknowledgedFrames;
+
+    PacketParser m_Parser;
+};
+
+// receiver side: rebuilds the frames and answers with acknowledges / key frame requests
+class FrameDecoder {
+public:
+    explicit FrameDecoder(int numberOfLeds_p);
+
+    // returns number of frames that have been completed by the given data
+    int ProcessIncoming(const std::uint8_t* data_p, std::size_t size_p);
+
+    bool HasFrame() const {return !m_History.empty();}
+    const FrameBuffer& GetFrame() const {return m_History.back().second;}
+
+    // packets that have to be sent back to the encoder, buffer is emptied
+    PacketBuffer TakeOutgoing();
+
+    long GetNumberOfDecodedFrames() const {return m_DecodedFrames;}
+    long GetNumberOfDroppedPackets() const {return m_DroppedPackets;}
+    long GetNumberOfDroppedBytes() const {return m_Parser.GetNumberOfDroppedBytes();}
+
+private:
+    bool ApplySpans(const Packet& packet_p, FrameBuffer& frame_p) const;
+
+    int m_NumberOfLeds;
+    std::deque<std::pair<std::uint16_t, FrameBuffer>> m_History;
+    bool m_KeyFrameRequested = false;
+
+    PacketParser m_Parser;
+    PacketBuffer m_Outgoing;
+
+    long m_DecodedFrames = 0;
+    long m_DroppedPackets = 0;
+};
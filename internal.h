@@ -2,6 +2,11 @@
 
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
 
 // not yet really checked for hw connection
 enum ConnectionState {
@@ -41,6 +46,10 @@ public:
         m_Blue = blue_p;
     }
 
+    bool operator==(const LedColor& other_p) const {
+        return m_Red == other_p.m_Red && m_Green == other_p.m_Green && m_Blue == other_p.m_Blue;
+    }
+
 private:
     int m_Red = 0;
     int m_Green = 0;
@@ -67,6 +76,9 @@ public:
         }
     }
 
+    // color without regarding blinking
+    const LedColor& GetBaseColor() const {return m_Color;}
+
     void SetColor(LedColor color_p) {
         m_Color = color_p;
     }
@@ -134,11 +146,276 @@ public:
         }
     }
 
+    int GetWidth() const {return m_WidthInPixel;}
+    int GetHeight() const {return m_HeightInPixel;}
+    bool IsInside(int x_p, int y_p) const {
+        return x_p >= 0 && x_p < m_WidthInPixel && y_p >= 0 && y_p < m_HeightInPixel;
+    }
+
+    // checked access for coordinates coming from outside
     Led& GetLed(int x_p, int y_p) {
-        return m_Leds.at(y_p).at(x_p);
+        if (!IsInside(x_p, y_p)) {
+            throw std::out_of_range("Display::GetLed: led is outside of display");
+        }
+        return m_Leds[y_p][x_p];
+    }
+
+    // no bounds check - only for coordinates that are already clipped against the display
+    Led* GetRowUnchecked(int y_p) {
+        return m_Leds[y_p].data();
+    }
+
+    //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    // drawing primitives - clipped once per primitive, parts outside of the display are ignored
+    //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+    void DrawLine(int x0_p, int y0_p, int x1_p, int y1_p, const LedColor& color_p) {
+        // all math in 64 bit, the deltas of int coordinates do not fit into an int (nor into a 32 bit long)
+        std::int64_t x0{x0_p};
+        std::int64_t y0{y0_p};
+        std::int64_t x1{x1_p};
+        std::int64_t y1{y1_p};
+        // far away endpoints are moved along the line onto a box around the display first, which keeps
+        // the products of the step clipping below 2^53 - lines within the box are drawn exactly
+        if (!ClipLineToBox(x0, y0, x1, y1)) {
+            return;
+        }
+
+        // step along the major axis, the minor axis follows with bresenham rounding
+        const bool xIsMajor{std::abs(x1 - x0) >= std::abs(y1 - y0)};
+        const std::int64_t major0{xIsMajor ? x0 : y0};
+        const std::int64_t minor0{xIsMajor ? y0 : x0};
+        const std::int64_t majorDelta{xIsMajor ? x1 - x0 : y1 - y0};
+        const std::int64_t minorDelta{xIsMajor ? y1 - y0 : x1 - x0};
+        const std::int64_t majorSize{xIsMajor ? m_WidthInPixel : m_HeightInPixel};
+        const std::int64_t minorSize{xIsMajor ? m_HeightInPixel : m_WidthInPixel};
+        const int majorStep{majorDelta < 0 ? -1 : 1};
+        const int minorStep{minorDelta < 0 ? -1 : 1};
+        const std::int64_t steps{std::abs(majorDelta)};
+        const std::int64_t minorSteps{std::abs(minorDelta)};
+
+        // minor offset of step i is floor((2 * i * minorSteps + steps) / (2 * steps)), so it does not decrease with i
+        // clip the range of steps against both axes
+        std::int64_t firstStep{0};
+        std::int64_t lastStep{steps};
+        ClipSteps(major0, majorStep, majorSize, firstStep, lastStep);
+        if (minorSteps == 0) {
+            if (minor0 < 0 || minor0 >= minorSize) {
+                return;
+            }
+        } else {
+            // offsets needed to stay inside: minorStep * offset within [-minor0, minorSize - 1 - minor0]
+            const std::int64_t lowestOffset{minorStep > 0 ? -minor0 : minor0 - (minorSize - 1)};
+            const std::int64_t highestOffset{minorStep > 0 ? minorSize - 1 - minor0 : minor0};
+            // offset(i) >= k <=> i >= ceil((2 * steps * k - steps) / (2 * minorSteps))
+            firstStep = std::max(firstStep, CeilDivide(2 * steps * lowestOffset - steps, 2 * minorSteps));
+            // offset(i) <= k <=> i <= floor((2 * steps * (k + 1) - steps - 1) / (2 * minorSteps))
+            lastStep = std::min(lastStep, FloorDivide(2 * steps * (highestOffset + 1) - steps - 1, 2 * minorSteps));
+        }
+        if (firstStep > lastStep) {
+            return;
+        }
+
+        const std::int64_t denominator{2 * std::max(steps, std::int64_t{1})};
+        const std::int64_t numerator{2 * firstStep * minorSteps + steps};
+        std::int64_t minorOffset{numerator / denominator};
+        std::int64_t remainder{numerator % denominator};
+        for (std::int64_t step = firstStep; step <= lastStep; step++) {
+            const int major{static_cast<int>(major0 + majorStep * step)};
+            const int minor{static_cast<int>(minor0 + minorStep * minorOffset)};
+            if (xIsMajor) {
+                GetRowUnchecked(minor)[major].SetColor(color_p);
+            } else {
+                GetRowUnchecked(major)[minor].SetColor(color_p);
+            }
+            remainder += 2 * minorSteps;
+            if (remainder >= denominator) {
+                remainder -= denominator;
+                minorOffset++;
+            }
+        }
+    }
+
+    void DrawRect(int x_p, int y_p, int width_p, int height_p, const LedColor& color_p, bool filled_p) {
+        if (width_p <= 0 || height_p <= 0) {
+            return;
+        }
+        // far edges in 64 bit (long is 32 bit on arm), x + width may not fit into an int
+        const std::int64_t rightEdge{static_cast<std::int64_t>(x_p) + width_p - 1};
+        const std::int64_t bottomEdge{static_cast<std::int64_t>(y_p) + height_p - 1};
+        const int left{std::max(x_p, 0)};
+        const int right{static_cast<int>(std::min(rightEdge, static_cast<std::int64_t>(m_WidthInPixel - 1)))};
+        const int top{std::max(y_p, 0)};
+        const int bottom{static_cast<int>(std::min(bottomEdge, static_cast<std::int64_t>(m_HeightInPixel - 1)))};
+        if (left > right || top > bottom) {
+            return;
+        }
+
+        if (filled_p) {
+            for (int y = top; y <= bottom; y++) {
+                FillSpanUnchecked(y, left, right, color_p);
+            }
+            return;
+        }
+
+        // outline: horizontal edges as spans, vertical edges only if they are inside
+        if (y_p == top) {
+            FillSpanUnchecked(top, left, right, color_p);
+        }
+        if (bottomEdge == bottom) {
+            FillSpanUnchecked(bottom, left, right, color_p);
+        }
+        for (int y = top; y <= bottom; y++) {
+            Led* rowOfLeds{GetRowUnchecked(y)};
+            if (x_p == left) {
+                rowOfLeds[left].SetColor(color_p);
+            }
+            if (rightEdge == right) {
+                rowOfLeds[right].SetColor(color_p);
+            }
+        }
+    }
+
+    void FillCircle(int centerX_p, int centerY_p, int radius_p, const LedColor& color_p) {
+        if (radius_p < 0) {
+            return;
+        }
+        // clipping in 64 bit, center +/- radius may not fit into an int
+        const std::int64_t radius{radius_p};
+        const int top{static_cast<int>(std::max(centerY_p - radius, std::int64_t{0}))};
+        const int bottom{static_cast<int>(std::min(centerY_p + radius, static_cast<std::int64_t>(m_HeightInPixel - 1)))};
+        for (int y = top; y <= bottom; y++) {
+            const std::int64_t dy{static_cast<std::int64_t>(y) - centerY_p};
+            const std::int64_t halfWidth{static_cast<std::int64_t>(std::sqrt(static_cast<double>(radius * radius - dy * dy)))};
+            const int left{static_cast<int>(std::max(centerX_p - halfWidth, std::int64_t{0}))};
+            const int right{static_cast<int>(std::min(centerX_p + halfWidth, static_cast<std::int64_t>(m_WidthInPixel - 1)))};
+            if (left <= right) {
+                FillSpanUnchecked(y, left, right, color_p);
+            }
+        }
+    }
+
+    // fills the area of leds having the same (base) color as the start led
+    void FloodFill(int x_p, int y_p, const LedColor& color_p) {
+        if (!IsInside(x_p, y_p)) {
+            return;
+        }
+        const LedColor areaColor{GetRowUnchecked(y_p)[x_p].GetBaseColor()};
+        if (areaColor == color_p) {
+            return;
+        }
+
+        // scanline fill: each seed fills its whole span, the rows above and below get one seed per span
+        std::vector<std::pair<int, int>> seeds{{x_p, y_p}};
+        while (!seeds.empty()) {
+            const int seedX{seeds.back().first};
+            const int seedY{seeds.back().second};
+            seeds.pop_back();
+
+            Led* rowOfLeds{GetRowUnchecked(seedY)};
+            if (!(rowOfLeds[seedX].GetBaseColor() == areaColor)) {
+                continue;
+            }
+            int left{seedX};
+            int right{seedX};
+            while (left > 0 && rowOfLeds[left - 1].GetBaseColor() == areaColor) {
+                left--;
+            }
+            while (right < m_WidthInPixel - 1 && rowOfLeds[right + 1].GetBaseColor() == areaColor) {
+                right++;
+            }
+            FillSpanUnchecked(seedY, left, right, color_p);
+
+            for (int neighbourY : {seedY - 1, seedY + 1}) {
+                if (neighbourY < 0 || neighbourY >= m_HeightInPixel) {
+                    continue;
+                }
+                const Led* neighbourRow{GetRowUnchecked(neighbourY)};
+                bool inSpan{false};
+                for (int x = left; x <= right; x++) {
+                    const bool isAreaColor{neighbourRow[x].GetBaseColor() == areaColor};
+                    if (isAreaColor && !inSpan) {
+                        seeds.emplace_back(x, neighbourY);
+                    }
+                    inSpan = isAreaColor;
+                }
+            }
+        }
     }
 
 private:
+    void FillSpanUnchecked(int y_p, int left_p, int right_p, const LedColor& color_p) {
+        Led* rowOfLeds{GetRowUnchecked(y_p)};
+        for (int x = left_p; x <= right_p; x++) {
+            rowOfLeds[x].SetColor(color_p);
+        }
+    }
+
+    // limits [firstStep_p, lastStep_p] to the steps of start_p + step_p * i within [0, size_p)
+    // limits [firstStep_p, lastStep_p] to the steps of start_p + step_p * i within [0, size_p)
+    static void ClipSteps(std::int64_t start_p, int step_p, std::int64_t size_p, std::int64_t& firstStep_p, std::int64_t& lastStep_p) {
+        if (step_p > 0) {
+            firstStep_p = std::max(firstStep_p, -start_p);
+            lastStep_p = std::min(lastStep_p, size_p - 1 - start_p);
+        } else {
+            firstStep_p = std::max(firstStep_p, start_p - (size_p - 1));
+            lastStep_p = std::min(lastStep_p, start_p);
+        }
+    }
+
+    // moves endpoints outside of +/- c_LineClipBox along the line onto the box (liang barsky),
+    // returns false if the line does not touch the box at all
+    static bool ClipLineToBox(std::int64_t& x0_p, std::int64_t& y0_p, std::int64_t& x1_p, std::int64_t& y1_p) {
+        constexpr std::int64_t c_LineClipBox{std::int64_t{1} << 24};
+        if (std::abs(x0_p) <= c_LineClipBox && std::abs(y0_p) <= c_LineClipBox
+            && std::abs(x1_p) <= c_LineClipBox && std::abs(y1_p) <= c_LineClipBox) {
+            return true;
+        }
+
+        const double deltaX{static_cast<double>(x1_p - x0_p)};
+        const double deltaY{static_cast<double>(y1_p - y0_p)};
+        const double box{static_cast<double>(c_LineClipBox)};
+        const double directions[4]{-deltaX, deltaX, -deltaY, deltaY};
+        const double distances[4]{x0_p + box, box - x0_p, y0_p + box, box - y0_p};
+        double enter{0.0};
+        double leave{1.0};
+        for (int edge = 0; edge < 4; edge++) {
+            if (directions[edge] == 0.0) {
+                if (distances[edge] < 0.0) {
+                    return false;
+                }
+                continue;
+            }
+            const double t{distances[edge] / directions[edge]};
+            if (directions[edge] < 0.0) {
+                enter = std::max(enter, t);
+            } else {
+                leave = std::min(leave, t);
+            }
+        }
+        if (enter > leave) {
+            return false;
+        }
+
+        const std::int64_t startX{x0_p};
+        const std::int64_t startY{y0_p};
+        x0_p = startX + std::llround(enter * deltaX);
+        y0_p = startY + std::llround(enter * deltaY);
+        x1_p = startX + std::llround(leave * deltaX);
+        y1_p = startY + std::llround(leave * deltaY);
+        return true;
+    }
+
+    static std::int64_t FloorDivide(std::int64_t numerator_p, std::int64_t denominator_p) {
+        const std::int64_t quotient{numerator_p / denominator_p};
+        return (numerator_p % denominator_p != 0 && numerator_p < 0) ? quotient - 1 : quotient;
+    }
+
+    static std::int64_t CeilDivide(std::int64_t numerator_p, std::int64_t denominator_p) {
+        const std::int64_t quotient{numerator_p / denominator_p};
+        return (numerator_p % denominator_p != 0 && numerator_p > 0) ? quotient + 1 : quotient;
+    }
+
     // resolution
     int m_WidthInPixel;
     int m_HeightInPixel;
@@ -1,12 +1,22 @@
 #include "library.h"
 #include "internal.h"
+#include "frametransport.h"
+#include "videosource.h"
 
 #include <SDL.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <iostream>
+#include <mutex>
 #include <thread>
 #include <sstream>
 
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // global objects
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -39,6 +49,20 @@ constexpr double c_LedWidth{c_WidthAvailableForLeds * 1.0 / c_NumberOfLedsX};
 constexpr int c_HeigthAvailableForLeds{c_FrameHeight - (c_NumberOfLedsY + 1) * c_LedOuterBorder};
 constexpr double c_LedHeight{c_HeigthAvailableForLeds * 1.0 / c_NumberOfLedsY};
 
+// hardware link (serial line, or pipe / socket to the simulator), -1 if not set
+// set from api calls and used by the cyclic loop
+constexpr int c_KeyFrameIntervalInFrames = 100; // every 5s at 20 fps
+std::mutex g_HardwareLinkMutex;
+int g_HardwareLinkFileDescriptor = -1;
+bool g_HardwareLinkReceivesAcknowledges = false;
+std::unique_ptr<FrameEncoder> g_FrameEncoder;
+FrameBuffer g_HardwareFrame(3 * c_NumberOfLedsX * c_NumberOfLedsY, 0);
+
+// video playback, set from api calls and read by the cyclic loop
+std::mutex g_VideoSourceMutex;
+std::unique_ptr<VideoSource> g_VideoSource;
+FrameBuffer g_VideoFrame;
+
 // time of start of library
 auto g_StartTimeOfLibrary = std::chrono::steady_clock::now();
 
@@ -110,13 +134,93 @@ static void DebugWrite(const std::string& debugText_p)
     }
 }
 
-static void HardawareAccess_SetLed(int /*x_p*/, int /*y_p*/, int /*red_p*/, int /*green_p*/, int /*blue_p*/) {
-    // just a dummy method now for later implementation
+// collects the led into the frame that is sent by HardawareAccess_SendFrame
+static void HardawareAccess_SetLed(int x_p, int y_p, int red_p, int green_p, int blue_p) {
+    const std::size_t position{3 * static_cast<std::size_t>(y_p * c_NumberOfLedsX + x_p)};
+    g_HardwareFrame[position] = static_cast<std::uint8_t>(std::min(std::max(red_p, 0), 255));
+    g_HardwareFrame[position + 1] = static_cast<std::uint8_t>(std::min(std::max(green_p, 0), 255));
+    g_HardwareFrame[position + 2] = static_cast<std::uint8_t>(std::min(std::max(blue_p, 0), 255));
+}
+
+static void HardawareAccess_ReadAcknowledges() {
+    pollfd pollFileDescriptor{g_HardwareLinkFileDescriptor, POLLIN, 0};
+    std::uint8_t receiveBuffer[256];
+    while (poll(&pollFileDescriptor, 1, 0) > 0 && (pollFileDescriptor.revents & POLLIN)) {
+        const ssize_t bytesRead{read(g_HardwareLinkFileDescriptor, receiveBuffer, sizeof(receiveBuffer))};
+        if (bytesRead <= 0) {
+            return;
+        }
+        g_FrameEncoder->ProcessIncoming(receiveBuffer, static_cast<std::size_t>(bytesRead));
+    }
+}
+
+// sends the collected frame as key or delta frame over the hardware link
+static void HardawareAccess_SendFrame() {
+    std::lock_guard<std::mutex> lock(g_HardwareLinkMutex);
+    if (g_HardwareLinkFileDescriptor < 0 || !g_FrameEncoder) {
+        return;
+    }
+
+    if (g_HardwareLinkReceivesAcknowledges) {
+        HardawareAccess_ReadAcknowledges();
+    }
+
+    const PacketBuffer packet{g_FrameEncoder->EncodeFrame(g_HardwareFrame)};
+    std::size_t bytesWritten{0};
+    while (bytesWritten < packet.size()) {
+        const ssize_t result{write(g_HardwareLinkFileDescriptor, packet.data() + bytesWritten, packet.size() - bytesWritten)};
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0 && errno == EPIPE) {
+            // receiver has gone away - don't keep on sending key frames into a dead link
+            DebugWrite("Hardware link closed by receiver! - link is disabled.");
+            g_HardwareLinkFileDescriptor = -1;
+            g_FrameEncoder.reset();
+            return;
+        }
+        if (result <= 0) {
+            DebugWrite("Writing frame to hardware link failed! - next frame is sent as key frame.");
+            g_FrameEncoder->RequestKeyFrame();
+            return;
+        }
+        bytesWritten += static_cast<std::size_t>(result);
+    }
+}
+
+// takes over the video frame that is due (if any) into the display leds
+static void VideoPlayback_Update(long timeStampInMs_p) {
+    std::lock_guard<std::mutex> lock(g_VideoSourceMutex);
+    if (!g_VideoSource) {
+        return;
+    }
+
+    if (g_VideoSource->GetFrameForTime(timeStampInMs_p, g_VideoFrame)) {
+        for (int y = 0; y < c_NumberOfLedsY; y++) {
+            Led* rowOfLeds{g_Display.GetRowUnchecked(y)};
+            const std::uint8_t* rgb{g_VideoFrame.data() + 3 * y * c_NumberOfLedsX};
+            for (int x = 0; x < c_NumberOfLedsX; x++, rgb += 3) {
+                rowOfLeds[x].SetColor(LedColor(rgb[0], rgb[1], rgb[2]));
+            }
+        }
+    } else if (g_VideoSource->IsFinished()) {
+        if (!g_VideoSource->GetErrorText().empty()) {
+            DebugWrite("Video playback stopped: " + g_VideoSource->GetErrorText());
+        }
+        DebugWrite("Video playback finished.");
+        g_VideoSource.reset();
+    }
 }
 
 void CyclicLoop() {
     const auto timeWindow = std::chrono::milliseconds(c_LoopCycleInMs);
 
+    // a closed pipe/socket on the hardware link must show up as EPIPE, not kill the process by SIGPIPE
+    sigset_t signalsToBlock;
+    sigemptyset(&signalsToBlock);
+    sigaddset(&signalsToBlock, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signalsToBlock, nullptr);
+
     if (g_LibraryState.IsGraphicalOutputEnabled()) {
         GraphicalOutput_DrawFrame();
     }
@@ -128,10 +232,13 @@ void CyclicLoop() {
         // determine timestamp before loop, to have the same for each led - keep them in sync
         auto timeStampInMs = std::chrono::duration_cast<std::chrono::milliseconds>(timeSinceStart).count();
 
+        VideoPlayback_Update(timeStampInMs);
+
         // get leds from display variable and update them if needed on real display
-        for (int x = 0; x < c_NumberOfLedsX; x++) {
-            for (int y = 0; y < c_NumberOfLedsY; y++) {
-                const LedColor currentLedColor = g_Display.GetLed(x, y).GetColor(timeStampInMs);
+        for (int y = 0; y < c_NumberOfLedsY; y++) {
+            const Led* rowOfLeds{g_Display.GetRowUnchecked(y)};
+            for (int x = 0; x < c_NumberOfLedsX; x++) {
+                const LedColor currentLedColor = rowOfLeds[x].GetColor(timeStampInMs);
 
                 const int red{currentLedColor.GetRed()};
                 const int green{currentLedColor.GetGreen()};
@@ -141,6 +248,7 @@ void CyclicLoop() {
                 HardawareAccess_SetLed(x, y, red, green, blue);
             }
         }
+        HardawareAccess_SendFrame();
         GraphicalOutput_UpdateScreen();
 
         auto timeToWaitUntil = start + timeWindow;
@@ -171,6 +279,21 @@ void Connect(bool enableDebugOutput, bool enableGraphicalOutput) {
     g_CyclicLoop = std::make_unique<std::thread>(CyclicLoop);
 }
 
+void SetHardwareLink(int fileDescriptor, bool receivesAcknowledges) {
+    std::stringstream outputStream;
+    outputStream << "Hardware link set to file descriptor " << fileDescriptor << " (acknowledges: " << receivesAcknowledges << ").";
+    DebugWrite(outputStream.str());
+
+    std::lock_guard<std::mutex> lock(g_HardwareLinkMutex);
+    g_HardwareLinkFileDescriptor = fileDescriptor;
+    g_HardwareLinkReceivesAcknowledges = receivesAcknowledges;
+    if (fileDescriptor >= 0) {
+        g_FrameEncoder = std::make_unique<FrameEncoder>(c_NumberOfLedsX * c_NumberOfLedsY, c_KeyFrameIntervalInFrames, receivesAcknowledges);
+    } else {
+        g_FrameEncoder.reset();
+    }
+}
+
 bool IsConnected() {
     bool isConnected{g_LibraryState.IsConnected()};
     std::string outputString{"Connection status requested! Connected: "};
@@ -201,30 +324,48 @@ void Disconnect() {
 }
 
 void LedOn(int x, int y, int r, int g, int b) {
-    std::stringstream outputStream;
-    outputStream << "Turn LED on: (" << x << "," << y << ") with color (" << r << "," << g << "," << b << ")";
-    DebugWrite(outputStream.str());
+    if (g_LibraryState.IsDebugOutputEnabled()) {
+        std::stringstream outputStream;
+        outputStream << "Turn LED on: (" << x << "," << y << ") with color (" << r << "," << g << "," << b << ")";
+        DebugWrite(outputStream.str());
+    }
 
     g_Display.GetLed(x, y).SetColor(LedColor(r, g, b));
 }
 
 void LedOff(int x, int y) {
-    std::stringstream outputStream;
-    outputStream << "Turn LED off: (" << x << "," << y << ").";
-    DebugWrite(outputStream.str());
+    if (g_LibraryState.IsDebugOutputEnabled()) {
+        std::stringstream outputStream;
+        outputStream << "Turn LED off: (" << x << "," << y << ").";
+        DebugWrite(outputStream.str());
+    }
 
     g_Display.GetLed(x, y).TurnOff();
 }
 
 bool LedIsOn(int x, int y) {
     bool isOn{g_Display.GetLed(x, y).IsOn()};
-    std::stringstream outputStream;
-    outputStream << "On/Off state of LED: (" << x << "," << y << ") requested: " << isOn;
-    DebugWrite(outputStream.str());
+    if (g_LibraryState.IsDebugOutputEnabled()) {
+        std::stringstream outputStream;
+        outputStream << "On/Off state of LED: (" << x << "," << y << ") requested: " << isOn;
+        DebugWrite(outputStream.str());
+    }
 
     return isOn;
 }
 
+void LedGetColor(int x, int y, int &r, int &g, int &b) {
+    const LedColor& color{g_Display.GetLed(x, y).GetBaseColor()};
+    r = color.GetRed();
+    g = color.GetGreen();
+    b = color.GetBlue();
+    if (g_LibraryState.IsDebugOutputEnabled()) {
+        std::stringstream outputStream;
+        outputStream << "Color of LED: (" << x << "," << y << ") requested: (" << r << "," << g << "," << b << ")";
+        DebugWrite(outputStream.str());
+    }
+}
+
 void ClearAll() {
     DebugWrite("Clearing complete display!");
 
@@ -260,3 +401,76 @@ void LedDisableBlinking(int x, int y) {
 
     return g_Display.GetLed(x, y).DisableBlinking();
 }
+
+void DrawLine(int x0, int y0, int x1, int y1, int r, int g, int b) {
+    if (g_LibraryState.IsDebugOutputEnabled()) {
+        std::stringstream outputStream;
+        outputStream << "Draw line: (" << x0 << "," << y0 << ") to (" << x1 << "," << y1 << ") with color (" << r << "," << g << "," << b << ")";
+        DebugWrite(outputStream.str());
+    }
+
+    g_Display.DrawLine(x0, y0, x1, y1, LedColor(r, g, b));
+}
+
+void DrawRect(int x, int y, int width, int height, int r, int g, int b, bool filled) {
+    if (g_LibraryState.IsDebugOutputEnabled()) {
+        std::stringstream outputStream;
+        outputStream << "Draw " << (filled ? "filled " : "") << "rectangle: (" << x << "," << y << ") size " << width << "x" << height
+                     << " with color (" << r << "," << g << "," << b << ")";
+        DebugWrite(outputStream.str());
+    }
+
+    g_Display.DrawRect(x, y, width, height, LedColor(r, g, b), filled);
+}
+
+void FillCircle(int x, int y, int radius, int r, int g, int b) {
+    if (g_LibraryState.IsDebugOutputEnabled()) {
+        std::stringstream outputStream;
+        outputStream << "Fill circle: (" << x << "," << y << ") radius " << radius << " with color (" << r << "," << g << "," << b << ")";
+        DebugWrite(outputStream.str());
+    }
+
+    g_Display.FillCircle(x, y, radius, LedColor(r, g, b));
+}
+
+void FloodFill(int x, int y, int r, int g, int b) {
+    if (g_LibraryState.IsDebugOutputEnabled()) {
+        std::stringstream outputStream;
+        outputStream << "Flood fill: (" << x << "," << y << ") with color (" << r << "," << g << "," << b << ")";
+        DebugWrite(outputStream.str());
+    }
+
+    g_Display.FloodFill(x, y, LedColor(r, g, b));
+}
+
+bool PlayVideo(const char* path, int rawWidth, int rawHeight, double rawFramesPerSecond) {
+    std::stringstream outputStream;
+    outputStream << "Play video: " << path;
+    if (rawWidth > 0) {
+        outputStream << " (raw rgb " << rawWidth << "x" << rawHeight << " at " << rawFramesPerSecond << " fps)";
+    }
+    DebugWrite(outputStream.str());
+
+    auto videoSource = std::make_unique<VideoSource>(c_NumberOfLedsX, c_NumberOfLedsY);
+    const VideoFormat format{rawWidth > 0 ? eVideoFormatRawRgb : eVideoFormatY4m};
+    if (!videoSource->Open(path, format, rawWidth, rawHeight, rawFramesPerSecond)) {
+        DebugWrite("Video could not be opened: " + videoSource->GetErrorText());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_VideoSourceMutex);
+    g_VideoSource = std::move(videoSource);
+    return true;
+}
+
+void StopVideo() {
+    DebugWrite("Stop video.");
+
+    std::lock_guard<std::mutex> lock(g_VideoSourceMutex);
+    g_VideoSource.reset();
+}
+
+bool IsVideoPlaying() {
+    std::lock_guard<std::mutex> lock(g_VideoSourceMutex);
+    return g_VideoSource != nullptr;
+}
@@ -12,6 +12,11 @@ void Disconnect();
 // returns true if connected
 bool IsConnected();
 
+// Send the frames as key/delta frame packets to a serial line (or a pipe/socket to the simulator).
+// A file descriptor of -1 disables the hardware link. Can be changed while connected.
+// If receivesAcknowledges is set, deltas are only built against frames acknowledged by the receiver.
+void SetHardwareLink(int fileDescriptor, bool receivesAcknowledges = false);
+
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // clear whole display
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -37,4 +42,28 @@ bool LedIsOn(int x, int y);
 
 void LedGetColor(int x, int y, int &r, int &g, int &b);
 
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// drawing primitives - parts outside of the display are clipped
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+void DrawLine(int x0, int y0, int x1, int y1, int r, int g, int b);
+// x/y is the upper left corner
+void DrawRect(int x, int y, int width, int height, int r, int g, int b, bool filled = false);
+void FillCircle(int x, int y, int radius, int r, int g, int b);
+// fills the area of leds with the same color as the led at x/y
+void FloodFill(int x, int y, int r, int g, int b);
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// video playback
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+// Plays a video from a file or pipe ("-" for stdin), downscaled to the display resolution.
+// Without rawWidth/rawHeight the input is read as Y4M (yuv420), otherwise as raw rgb24 frames.
+// Frames are taken over by the display loop, so playback needs a connected display.
+// Returns false if the input can not be opened - errors within the stream end the playback (see debug output).
+bool PlayVideo(const char* path, int rawWidth = 0, int rawHeight = 0, double rawFramesPerSecond = 25.0);
+void StopVideo();
+// returns false once the video has been played completely
+bool IsVideoPlaying();
+
 #endif //LEDDISPLAY_LIBRARY_H
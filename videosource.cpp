@@ -0,0 +1,495 @@
+#include "videosource.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// constants
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+constexpr std::size_t c_PrefetchQueueDepthInFrames = 4;
+constexpr std::size_t c_PipeReadChunkSize = 64 * 1024;
+constexpr int c_PipePollTimeoutInMs = 100;
+constexpr std::size_t c_MaxY4mLineLength = 1024;
+// larger sizes are taken as a corrupt header, the downscaler buffers grow with the width
+constexpr int c_MaxVideoSizeInPixel = 16384;
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// (static) helper routines
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+// adds each byte of the row to its column sum - this is where the time of downscaling goes
+static void AccumulateRow(std::uint32_t* sums_p, const std::uint8_t* row_p, std::size_t count_p) {
+    std::size_t index{0};
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; index + 16 <= count_p; index += 16) {
+        const uint8x16_t pixels = vld1q_u8(row_p + index);
+        const uint16x8_t low = vmovl_u8(vget_low_u8(pixels));
+        const uint16x8_t high = vmovl_u8(vget_high_u8(pixels));
+        vst1q_u32(sums_p + index, vaddw_u16(vld1q_u32(sums_p + index), vget_low_u16(low)));
+        vst1q_u32(sums_p + index + 4, vaddw_u16(vld1q_u32(sums_p + index + 4), vget_high_u16(low)));
+        vst1q_u32(sums_p + index + 8, vaddw_u16(vld1q_u32(sums_p + index + 8), vget_low_u16(high)));
+        vst1q_u32(sums_p + index + 12, vaddw_u16(vld1q_u32(sums_p + index + 12), vget_high_u16(high)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; index + 16 <= count_p; index += 16) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_p + index));
+        const __m128i low = _mm_unpacklo_epi8(pixels, zero);
+        const __m128i high = _mm_unpackhi_epi8(pixels, zero);
+        __m128i* sums = reinterpret_cast<__m128i*>(sums_p + index);
+        _mm_storeu_si128(sums, _mm_add_epi32(_mm_loadu_si128(sums), _mm_unpacklo_epi16(low, zero)));
+        _mm_storeu_si128(sums + 1, _mm_add_epi32(_mm_loadu_si128(sums + 1), _mm_unpackhi_epi16(low, zero)));
+        _mm_storeu_si128(sums + 2, _mm_add_epi32(_mm_loadu_si128(sums + 2), _mm_unpacklo_epi16(high, zero)));
+        _mm_storeu_si128(sums + 3, _mm_add_epi32(_mm_loadu_si128(sums + 3), _mm_unpackhi_epi16(high, zero)));
+    }
+#endif
+    for (; index < count_p; index++) {
+        sums_p[index] += row_p[index];
+    }
+}
+
+// width or height from a y4m header, implausible values come back as -1
+static int ParseVideoSize(const std::string& value_p) {
+    errno = 0;
+    const long size{std::strtol(value_p.c_str(), nullptr, 10)};
+    if (errno != 0 || size < 0 || size > c_MaxVideoSizeInPixel) {
+        return -1;
+    }
+    return static_cast<int>(size);
+}
+
+static std::uint8_t ClampToByte(int value_p) {
+    return static_cast<std::uint8_t>(std::min(std::max(value_p, 0), 255));
+}
+
+// BT.601 in fixed point (8 bit fraction)
+static void YuvToRgb(int y_p, int u_p, int v_p, bool fullRange_p, std::uint8_t* rgb_p) {
+    const int d{u_p - 128};
+    const int e{v_p - 128};
+    if (fullRange_p) {
+        const int y{y_p << 8};
+        rgb_p[0] = ClampToByte((y + 359 * e + 128) >> 8);
+        rgb_p[1] = ClampToByte((y - 88 * d - 183 * e + 128) >> 8);
+        rgb_p[2] = ClampToByte((y + 454 * d + 128) >> 8);
+    } else {
+        const int c{298 * (y_p - 16)};
+        rgb_p[0] = ClampToByte((c + 409 * e + 128) >> 8);
+        rgb_p[1] = ClampToByte((c - 100 * d - 208 * e + 128) >> 8);
+        rgb_p[2] = ClampToByte((c + 516 * d + 128) >> 8);
+    }
+}
+
+// splits sourceSize_p into targetSize_p boxes, each box covers at least one source pixel
+static void BoxBoundaries(int sourceSize_p, int targetSize_p, std::vector<int>& begin_p, std::vector<int>& end_p) {
+    begin_p.resize(targetSize_p);
+    end_p.resize(targetSize_p);
+    for (int target = 0; target < targetSize_p; target++) {
+        const int begin{std::min(static_cast<int>(static_cast<long>(target) * sourceSize_p / targetSize_p), sourceSize_p - 1)};
+        const int end{static_cast<int>(static_cast<long>(target + 1) * sourceSize_p / targetSize_p)};
+        begin_p[target] = begin;
+        end_p[target] = std::max(end, begin + 1);
+    }
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// video input
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+VideoInput::~VideoInput() {
+    Close();
+}
+
+bool VideoInput::Open(const std::string& path_p) {
+    Close();
+
+    if (path_p == "-") {
+        m_FileDescriptor = STDIN_FILENO;
+        m_OwnsFileDescriptor = false;
+    } else {
+        // non blocking: opening a fifo must not wait for its writer, reading polls anyway
+        m_FileDescriptor = open(path_p.c_str(), O_RDONLY | O_NONBLOCK);
+        if (m_FileDescriptor < 0) {
+            return false;
+        }
+        m_OwnsFileDescriptor = true;
+    }
+
+    // regular files are mapped instead of copied through read()
+    struct stat fileStatus{};
+    if (fstat(m_FileDescriptor, &fileStatus) == 0 && S_ISREG(fileStatus.st_mode) && fileStatus.st_size > 0) {
+        void* mappedData{mmap(nullptr, static_cast<std::size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0)};
+        if (mappedData != MAP_FAILED) {
+            madvise(mappedData, static_cast<std::size_t>(fileStatus.st_size), MADV_SEQUENTIAL);
+            m_MappedData = static_cast<const std::uint8_t*>(mappedData);
+            m_MappedSize = static_cast<std::size_t>(fileStatus.st_size);
+            m_MappedPosition = 0;
+        }
+    }
+    return true;
+}
+
+void VideoInput::Close() {
+    if (m_MappedData != nullptr) {
+        munmap(const_cast<std::uint8_t*>(m_MappedData), m_MappedSize);
+        m_MappedData = nullptr;
+        m_MappedSize = 0;
+        m_MappedPosition = 0;
+    }
+    if (m_OwnsFileDescriptor && m_FileDescriptor >= 0) {
+        close(m_FileDescriptor);
+    }
+    m_FileDescriptor = -1;
+    m_OwnsFileDescriptor = false;
+    m_Buffer.clear();
+    m_BufferPosition = 0;
+}
+
+const std::uint8_t* VideoInput::Read(std::size_t size_p, const std::atomic<bool>& stopRequested_p) {
+    if (m_MappedData != nullptr) {
+        if (m_MappedSize - m_MappedPosition < size_p) {
+            return nullptr;
+        }
+        const std::uint8_t* data{m_MappedData + m_MappedPosition};
+        m_MappedPosition += size_p;
+        return data;
+    }
+
+    if (m_FileDescriptor < 0) {
+        return nullptr;
+    }
+
+    if (m_Buffer.size() - m_BufferPosition >= size_p) {
+        const std::uint8_t* data{m_Buffer.data() + m_BufferPosition};
+        m_BufferPosition += size_p;
+        return data;
+    }
+
+    // keep only the unread part, then fill up from the pipe
+    m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + m_BufferPosition);
+    m_BufferPosition = 0;
+    while (m_Buffer.size() < size_p) {
+        if (stopRequested_p) {
+            return nullptr;
+        }
+        pollfd pollFileDescriptor{m_FileDescriptor, POLLIN, 0};
+        const int pollResult{poll(&pollFileDescriptor, 1, c_PipePollTimeoutInMs)};
+        if (pollResult < 0 && errno != EINTR) {
+            return nullptr;
+        }
+        if (pollResult <= 0) {
+            continue;
+        }
+
+        const std::size_t oldSize{m_Buffer.size()};
+        m_Buffer.resize(oldSize + std::max(c_PipeReadChunkSize, size_p - oldSize));
+        const ssize_t bytesRead{read(m_FileDescriptor, m_Buffer.data() + oldSize, m_Buffer.size() - oldSize)};
+        m_Buffer.resize(oldSize + static_cast<std::size_t>(std::max<ssize_t>(bytesRead, 0)));
+        if (bytesRead == 0 || (bytesRead < 0 && errno != EINTR && errno != EAGAIN)) {
+            return nullptr;
+        }
+    }
+
+    m_BufferPosition = size_p;
+    return m_Buffer.data();
+}
+
+bool VideoInput::ReadLine(std::string& line_p, const std::atomic<bool>& stopRequested_p) {
+    line_p.clear();
+    while (line_p.size() < c_MaxY4mLineLength) {
+        const std::uint8_t* character{Read(1, stopRequested_p)};
+        if (character == nullptr) {
+            return false;
+        }
+        if (*character == '\n') {
+            return true;
+        }
+        line_p.push_back(static_cast<char>(*character));
+    }
+    return false;
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// area downscaler
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+AreaDownscaler::AreaDownscaler(int sourceWidth_p, int sourceHeight_p, int channels_p, int targetWidth_p, int targetHeight_p)
+        : m_SourceWidth{sourceWidth_p}, m_Channels{channels_p}, m_TargetWidth{targetWidth_p}, m_TargetHeight{targetHeight_p},
+          m_ColumnSums(static_cast<std::size_t>(sourceWidth_p) * channels_p) {
+    BoxBoundaries(sourceWidth_p, targetWidth_p, m_ColumnBegin, m_ColumnEnd);
+    BoxBoundaries(sourceHeight_p, targetHeight_p, m_RowBegin, m_RowEnd);
+}
+
+void AreaDownscaler::Scale(const std::uint8_t* source_p, std::size_t sourceStride_p, std::uint8_t* target_p) {
+    const std::size_t bytesPerRow{static_cast<std::size_t>(m_SourceWidth) * m_Channels};
+
+    for (int targetY = 0; targetY < m_TargetHeight; targetY++) {
+        // vertical: sum up all source rows of the box
+        std::fill(m_ColumnSums.begin(), m_ColumnSums.end(), 0);
+        for (int sourceY = m_RowBegin[targetY]; sourceY < m_RowEnd[targetY]; sourceY++) {
+            AccumulateRow(m_ColumnSums.data(), source_p + sourceY * sourceStride_p, bytesPerRow);
+        }
+        const int rowsInBox{m_RowEnd[targetY] - m_RowBegin[targetY]};
+
+        // horizontal: sum up the column sums of the box
+        std::uint8_t* targetRow{target_p + static_cast<std::size_t>(targetY) * m_TargetWidth * m_Channels};
+        for (int targetX = 0; targetX < m_TargetWidth; targetX++) {
+            const std::uint32_t pixelsInBox{static_cast<std::uint32_t>(rowsInBox * (m_ColumnEnd[targetX] - m_ColumnBegin[targetX]))};
+            for (int channel = 0; channel < m_Channels; channel++) {
+                std::uint32_t sum{0};
+                for (int sourceX = m_ColumnBegin[targetX]; sourceX < m_ColumnEnd[targetX]; sourceX++) {
+                    sum += m_ColumnSums[sourceX * m_Channels + channel];
+                }
+                targetRow[targetX * m_Channels + channel] = static_cast<std::uint8_t>((sum + pixelsInBox / 2) / pixelsInBox);
+            }
+        }
+    }
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// video source
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+bool VideoSource::Open(const std::string& path_p, VideoFormat format_p, int rawWidth_p, int rawHeight_p,
+                       double rawFramesPerSecond_p) {
+    Stop();
+    m_StopRequested = false;
+    m_EndOfStream = false;
+    m_PlaybackStartInMs = -1;
+    m_PlaybackTimeInMs = -1;
+    m_Queue.clear();
+    m_Downscalers.clear();
+    m_ErrorText.clear();
+    m_Format = format_p;
+
+    if (!m_Input.Open(path_p)) {
+        m_ErrorText = "Could not open video input " + path_p;
+        return false;
+    }
+
+    if (format_p == eVideoFormatRawRgb) {
+        m_SourceWidth = rawWidth_p;
+        m_SourceHeight = rawHeight_p;
+        m_FramesPerSecond = rawFramesPerSecond_p;
+        if (m_SourceWidth <= 0 || m_SourceHeight <= 0 || m_SourceWidth > c_MaxVideoSizeInPixel
+            || m_SourceHeight > c_MaxVideoSizeInPixel || m_FramesPerSecond <= 0) {
+            m_ErrorText = "Invalid video size or frame rate";
+            m_Input.Close();
+            return false;
+        }
+    }
+
+    // the y4m header is read on the decode thread - on a pipe it may take a while or never come
+    m_DecodeThread = std::thread(&VideoSource::DecodeLoop, this);
+    return true;
+}
+
+bool VideoSource::PrepareDecoding() {
+    if (m_Format == eVideoFormatY4m) {
+        if (!ReadY4mHeader()) {
+            return false;
+        }
+        if (m_SourceWidth <= 0 || m_SourceHeight <= 0 || m_SourceWidth > c_MaxVideoSizeInPixel
+            || m_SourceHeight > c_MaxVideoSizeInPixel || m_FramesPerSecond <= 0) {
+            m_ErrorText = "Invalid video size or frame rate in Y4M header";
+            return false;
+        }
+    }
+
+    const std::size_t targetPixels{static_cast<std::size_t>(m_TargetWidth) * m_TargetHeight};
+    if (m_Format == eVideoFormatY4m) {
+        // chroma is averaged in its own (half) resolution, conversion to rgb is done on the small planes only
+        const int chromaWidth{(m_SourceWidth + 1) / 2};
+        const int chromaHeight{(m_SourceHeight + 1) / 2};
+        m_Downscalers.emplace_back(m_SourceWidth, m_SourceHeight, 1, m_TargetWidth, m_TargetHeight);
+        m_Downscalers.emplace_back(chromaWidth, chromaHeight, 1, m_TargetWidth, m_TargetHeight);
+        m_Downscalers.emplace_back(chromaWidth, chromaHeight, 1, m_TargetWidth, m_TargetHeight);
+        m_ScaledY.resize(targetPixels);
+        m_ScaledU.resize(targetPixels);
+        m_ScaledV.resize(targetPixels);
+    } else {
+        m_Downscalers.emplace_back(m_SourceWidth, m_SourceHeight, 3, m_TargetWidth, m_TargetHeight);
+    }
+    return true;
+}
+
+void VideoSource::Stop() {
+    {
+        // set under the queue mutex, otherwise the wake up gets lost if the decode thread
+        // has just checked the flag and is about to wait
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        m_StopRequested = true;
+    }
+    m_QueueNotFull.notify_all();
+    if (m_DecodeThread.joinable()) {
+        m_DecodeThread.join();
+    }
+    m_Input.Close();
+}
+
+// header: YUV4MPEG2 W<width> H<height> F<num>:<den> [C<colorspace>] [X<option>] ...
+bool VideoSource::ReadY4mHeader() {
+    std::string header;
+    const bool headerRead{m_Input.ReadLine(header, m_StopRequested)};
+    if (m_StopRequested) {
+        return false;
+    }
+    if (!headerRead || header.compare(0, 9, "YUV4MPEG2") != 0) {
+        m_ErrorText = "Input is not a Y4M stream";
+        return false;
+    }
+
+    m_SourceWidth = 0;
+    m_SourceHeight = 0;
+    m_FramesPerSecond = 25.0;
+    m_FullColorRange = false;
+
+    std::istringstream headerStream{header.substr(9)};
+    std::string token;
+    while (headerStream >> token) {
+        const std::string value{token.substr(1)};
+        switch (token[0]) {
+            case 'W':
+                m_SourceWidth = ParseVideoSize(value);
+                break;
+            case 'H':
+                m_SourceHeight = ParseVideoSize(value);
+                break;
+            case 'F': {
+                const std::size_t colon{value.find(':')};
+                const double numerator{std::atof(value.substr(0, colon).c_str())};
+                const double denominator{colon == std::string::npos ? 1.0 : std::atof(value.substr(colon + 1).c_str())};
+                m_FramesPerSecond = denominator > 0 ? numerator / denominator : 0.0;
+                break;
+            }
+            case 'C':
+                // 8 bit 4:2:0 only - the variants differ in chroma siting, which does not matter after averaging
+                if (value != "420" && value != "420jpeg" && value != "420mpeg2" && value != "420paldv") {
+                    m_ErrorText = "Only Y4M with 8 bit 4:2:0 chroma is supported, got C" + value;
+                    return false;
+                }
+                break;
+            case 'X':
+                if (value == "COLORRANGE=FULL") {
+                    m_FullColorRange = true;
+                }
+                break;
+            default:
+                // interlacing, aspect ratio, ... are not of interest for the display
+                break;
+        }
+    }
+    return true;
+}
+
+bool VideoSource::DecodeNextFrame(FrameBuffer& frame_p, bool scale_p) {
+    const std::size_t targetPixels{static_cast<std::size_t>(m_TargetWidth) * m_TargetHeight};
+    frame_p.resize(3 * targetPixels);
+
+    if (m_Format == eVideoFormatRawRgb) {
+        const std::size_t frameSize{3 * static_cast<std::size_t>(m_SourceWidth) * m_SourceHeight};
+        const std::uint8_t* frameData{m_Input.Read(frameSize, m_StopRequested)};
+        if (frameData == nullptr) {
+            return false;
+        }
+        if (!scale_p) {
+            return true;
+        }
+        m_Downscalers[0].Scale(frameData, 3 * static_cast<std::size_t>(m_SourceWidth), frame_p.data());
+        return true;
+    }
+
+    std::string frameHeader;
+    if (!m_Input.ReadLine(frameHeader, m_StopRequested) || frameHeader.compare(0, 5, "FRAME") != 0) {
+        return false;
+    }
+    const std::size_t chromaWidth{static_cast<std::size_t>(m_SourceWidth + 1) / 2};
+    const std::size_t chromaHeight{static_cast<std::size_t>(m_SourceHeight + 1) / 2};
+    const std::size_t lumaSize{static_cast<std::size_t>(m_SourceWidth) * m_SourceHeight};
+    const std::uint8_t* frameData{m_Input.Read(lumaSize + 2 * chromaWidth * chromaHeight, m_StopRequested)};
+    if (frameData == nullptr) {
+        return false;
+    }
+    if (!scale_p) {
+        return true;
+    }
+
+    m_Downscalers[0].Scale(frameData, static_cast<std::size_t>(m_SourceWidth), m_ScaledY.data());
+    m_Downscalers[1].Scale(frameData + lumaSize, chromaWidth, m_ScaledU.data());
+    m_Downscalers[2].Scale(frameData + lumaSize + chromaWidth * chromaHeight, chromaWidth, m_ScaledV.data());
+    for (std::size_t pixel = 0; pixel < targetPixels; pixel++) {
+        YuvToRgb(m_ScaledY[pixel], m_ScaledU[pixel], m_ScaledV[pixel], m_FullColorRange, frame_p.data() + 3 * pixel);
+    }
+    return true;
+}
+
+void VideoSource::DecodeLoop() {
+    long frameNumber{0};
+    const bool isPrepared{PrepareDecoding()};
+    while (isPrepared && !m_StopRequested) {
+        const long presentationTimeInMs{static_cast<long>(frameNumber * 1000.0 / m_FramesPerSecond)};
+        const long nextPresentationTimeInMs{static_cast<long>((frameNumber + 1) * 1000.0 / m_FramesPerSecond)};
+        frameNumber++;
+
+        // if the following frame is already due, GetFrameForTime would skip this one anyway - so it is
+        // only read, not scaled, and does not take a place in the queue (keeps up with high frame rates)
+        const bool isSuperseded{m_PlaybackTimeInMs >= 0 && nextPresentationTimeInMs <= m_PlaybackTimeInMs};
+        FrameBuffer frame;
+        if (!DecodeNextFrame(frame, !isSuperseded)) {
+            break;
+        }
+        if (isSuperseded) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_QueueMutex);
+        m_QueueNotFull.wait(lock, [this] {return m_StopRequested || m_Queue.size() < c_PrefetchQueueDepthInFrames;});
+        if (m_StopRequested) {
+            break;
+        }
+        m_Queue.emplace_back(presentationTimeInMs, std::move(frame));
+    }
+
+    std::lock_guard<std::mutex> lock(m_QueueMutex);
+    m_EndOfStream = true;
+}
+
+bool VideoSource::GetFrameForTime(long timeStampInMs_p, FrameBuffer& frame_p) {
+    std::lock_guard<std::mutex> lock(m_QueueMutex);
+    if (m_PlaybackStartInMs < 0) {
+        if (m_Queue.empty()) {
+            return false;
+        }
+        m_PlaybackStartInMs = timeStampInMs_p;
+    }
+    // also published while the queue is empty, so a decode thread that fell behind can catch up
+    const long playbackTimeInMs{timeStampInMs_p - m_PlaybackStartInMs};
+    m_PlaybackTimeInMs = playbackTimeInMs;
+
+    bool frameFound{false};
+    while (!m_Queue.empty() && m_Queue.front().first <= playbackTimeInMs) {
+        frame_p = std::move(m_Queue.front().second);
+        m_Queue.pop_front();
+        frameFound = true;
+    }
+    if (frameFound) {
+        m_QueueNotFull.notify_one();
+    }
+    return frameFound;
+}
+
+bool VideoSource::IsFinished() {
+    std::lock_guard<std::mutex> lock(m_QueueMutex);
+    return m_EndOfStream && m_Queue.empty();
+}
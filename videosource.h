@@ -0,0 +1,139 @@
+#pragma once
+
+#include "frametransport.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// streaming video source: raw rgb24 or y4m (yuv420) from a file or pipe,
+// area averaged down to display resolution on a decode thread
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+// sequential byte input - regular files are memory mapped, pipes (or "-" for stdin) are read
+class VideoInput {
+public:
+    VideoInput() {};
+    ~VideoInput();
+    VideoInput(const VideoInput&) = delete;
+    VideoInput& operator=(const VideoInput&) = delete;
+
+    bool Open(const std::string& path_p);
+    void Close();
+
+    // returns pointer to the next size_p bytes (valid until the next call), nullptr at end of input
+    // reading from a pipe gives up if stopRequested_p gets set
+    const std::uint8_t* Read(std::size_t size_p, const std::atomic<bool>& stopRequested_p);
+    // reads a line without the trailing '\n'
+    bool ReadLine(std::string& line_p, const std::atomic<bool>& stopRequested_p);
+
+    bool IsMemoryMapped() const {return m_MappedData != nullptr;}
+
+private:
+    int m_FileDescriptor = -1;
+    bool m_OwnsFileDescriptor = false;
+
+    // memory mapped file
+    const std::uint8_t* m_MappedData = nullptr;
+    std::size_t m_MappedSize = 0;
+    std::size_t m_MappedPosition = 0;
+
+    // buffer for pipe input
+    std::vector<std::uint8_t> m_Buffer;
+    std::size_t m_BufferPosition = 0;
+};
+
+// averages all source pixels covered by a target pixel, works on one plane with interleaved channels
+class AreaDownscaler {
+public:
+    AreaDownscaler(int sourceWidth_p, int sourceHeight_p, int channels_p, int targetWidth_p, int targetHeight_p);
+
+    // target needs targetWidth * targetHeight * channels bytes
+    void Scale(const std::uint8_t* source_p, std::size_t sourceStride_p, std::uint8_t* target_p);
+
+private:
+    int m_SourceWidth;
+    int m_Channels;
+    int m_TargetWidth;
+    int m_TargetHeight;
+
+    // source pixel range [begin, end) of each target column / row
+    std::vector<int> m_ColumnBegin;
+    std::vector<int> m_ColumnEnd;
+    std::vector<int> m_RowBegin;
+    std::vector<int> m_RowEnd;
+
+    // sum of the source rows of one target row, per source column and channel
+    std::vector<std::uint32_t> m_ColumnSums;
+};
+
+enum VideoFormat {
+    eVideoFormatY4m = 0,
+    eVideoFormatRawRgb = 1
+};
+
+class VideoSource {
+public:
+    VideoSource(int targetWidth_p, int targetHeight_p) : m_TargetWidth{targetWidth_p}, m_TargetHeight{targetHeight_p} {}
+    ~VideoSource() {Stop();}
+
+    // opens the input and starts the decode thread, does not block on pipes
+    // for raw rgb24 size and frame rate must be given, y4m brings them in its header (read by the decode thread,
+    // so an invalid header shows up as finished playback with an error text)
+    bool Open(const std::string& path_p, VideoFormat format_p, int rawWidth_p = 0, int rawHeight_p = 0,
+              double rawFramesPerSecond_p = 25.0);
+    void Stop();
+
+    // returns the newest frame that is due at the given time (frames in between are skipped),
+    // false if there is no new frame - playback time starts with the first call
+    bool GetFrameForTime(long timeStampInMs_p, FrameBuffer& frame_p);
+    // end of input reached and all frames shown
+    bool IsFinished();
+
+    // valid after a failed Open or once IsFinished returns true
+    const std::string& GetErrorText() const {return m_ErrorText;}
+
+private:
+    // reads the header (y4m) and sets up the downscalers, runs on the decode thread
+    bool PrepareDecoding();
+    bool ReadY4mHeader();
+    // reads the next frame, without scaling it if scale_p is false
+    bool DecodeNextFrame(FrameBuffer& frame_p, bool scale_p);
+    void DecodeLoop();
+
+    int m_TargetWidth;
+    int m_TargetHeight;
+
+    VideoInput m_Input;
+    VideoFormat m_Format = eVideoFormatY4m;
+    int m_SourceWidth = 0;
+    int m_SourceHeight = 0;
+    double m_FramesPerSecond = 25.0;
+    bool m_FullColorRange = false;
+    std::string m_ErrorText;
+
+    // downscaled planes (y4m) before color conversion
+    std::vector<std::uint8_t> m_ScaledY;
+    std::vector<std::uint8_t> m_ScaledU;
+    std::vector<std::uint8_t> m_ScaledV;
+    std::vector<AreaDownscaler> m_Downscalers;
+
+    // prefetch queue between decode thread and render loop: (presentation time in ms, frame)
+    std::thread m_DecodeThread;
+    std::atomic<bool> m_StopRequested{false};
+    std::mutex m_QueueMutex;
+    std::condition_variable m_QueueNotFull;
+    std::deque<std::pair<long, FrameBuffer>> m_Queue;
+    bool m_EndOfStream = false;
+    long m_PlaybackStartInMs = -1;
+    // playback time of the last GetFrameForTime call, for skipping late frames in the decode thread
+    std::atomic<long> m_PlaybackTimeInMs{-1};
+};